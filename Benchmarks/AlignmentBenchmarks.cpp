@@ -0,0 +1,84 @@
+#include "Scenarios.hpp"
+
+#include <cstdint>
+#include <iostream>
+
+namespace bench
+{
+    namespace
+    {
+        /// Brightness of every pixel summed row by row, the kind of loop the compiler vectorizes and
+        /// that runs faster when each row starts on a vector boundary.
+        uint64_t SumLuma(const uint8_t* Data, int Width, int Height, int Stride)
+        {
+            uint64_t sum = 0;
+            for (int y = 0; y < Height; y++)
+            {
+                const uint8_t* row = Data + static_cast<std::size_t>(y) * Stride;
+                uint32_t rowsum = 0;
+                for (int x = 0; x < Width * 4; x += 4)
+                {
+                    rowsum += row[x] * 77u + row[x + 1] * 150u + row[x + 2] * 29u;
+                }
+                sum += rowsum >> 8;
+            }
+            return sum;
+        }
+
+        /// Reads every frame of an odd width clip with rows aligned to Alignment bytes and reports
+        /// conversion and post processing cost per frame.
+        void RunAlignment(const std::string& Filename, int Alignment, JsonWriter& Writer)
+        {
+            mt::DataSource data;
+            if (!data.LoadFromFile(Filename, true, false)) return;
+            data.SetRowAlignment(Alignment);
+            std::cerr << "alignment: " << Alignment << " bytes" << std::endl;
+            mt::FrameReader reader(data);
+            uint64_t frames = 0;
+            uint64_t alignedrows = 0;
+            uint64_t rows = 0;
+            uint64_t checksum = 0;
+            int stride = 0;
+            std::chrono::steady_clock::duration processtime(0);
+            for (auto& frame : reader)
+            {
+                const uint8_t* pixels = frame->GetRGBABuffer();
+                stride = frame->stride;
+                for (int y = 0; y < frame->height; y++)
+                {
+                    if (reinterpret_cast<std::uintptr_t>(pixels + static_cast<std::size_t>(y) * stride) % Alignment == 0) alignedrows++;
+                }
+                rows += frame->height;
+                auto processstart = std::chrono::steady_clock::now();
+                checksum += SumLuma(pixels, frame->width, frame->height, stride);
+                processtime += std::chrono::steady_clock::now() - processstart;
+                frames++;
+            }
+            mt::DataSourceStats stats = data.GetStats();
+            Writer.BeginObject();
+            Writer.Field("alignment", Alignment);
+            Writer.Field("stride", stride);
+            Writer.Field("frames", frames);
+            Writer.Field("aligned_row_fraction", rows > 0 ? static_cast<double>(alignedrows) / rows : 0.0);
+            Writer.Field("convert_avg_us", static_cast<long long>(stats.converttime.GetAverage().count()));
+            Writer.Field("process_avg_us", frames > 0 ? ToSeconds(processtime) * 1000000.0 / frames : 0.0);
+            Writer.Field("checksum", checksum);
+            Writer.EndObject();
+        }
+    }
+
+    void RunAlignmentBenchmark(const Options& Options, JsonWriter& Writer)
+    {
+        // 1278 * 4 bytes per row is not a multiple of 16, packed rows drift off every boundary
+        ClipSpec spec("mpeg4_1278x718_gop30_b0", AV_CODEC_ID_MPEG4, 1278, 718, 30, 0);
+        std::string filename = PrepareClip(Options, spec);
+        if (filename.empty()) return;
+        Writer.Key("alignment");
+        Writer.BeginArray();
+        for (int alignment : { 1, 16, 32, 64, 256 })
+        {
+            RunAlignment(filename, alignment, Writer);
+        }
+        Writer.EndArray();
+    }
+}
@@ -0,0 +1,112 @@
+#include "Scenarios.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace bench
+{
+    namespace
+    {
+        /// Single threaded event loop standing in for a job system's executor.
+        class TaskQueue
+        {
+        private:
+            std::mutex m_lock;
+            std::condition_variable m_condition;
+            std::deque<std::function<void()>> m_tasks;
+
+        public:
+            void Post(std::function<void()> Task)
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                m_tasks.push_back(std::move(Task));
+                m_condition.notify_one();
+            }
+
+            void RunUntil(const std::function<bool()>& Done)
+            {
+                while (!Done())
+                {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lock(m_lock);
+                        if (!m_condition.wait_for(lock, std::chrono::milliseconds(100), [this]() { return !m_tasks.empty(); })) continue;
+                        task = std::move(m_tasks.front());
+                        m_tasks.pop_front();
+                    }
+                    task();
+                }
+            }
+        };
+
+        /// Many sources on the shared scheduler read to the end through RequestNextFrame, all of
+        /// them consumed on one executor thread so no thread ever blocks waiting for a frame.
+        void RunAsyncReaders(const Options& Options, const std::string& Filename, JsonWriter& Writer)
+        {
+            std::cerr << "async: " << Options.sources << " readers" << std::endl;
+            TaskQueue queue;
+            mt::Executor executor = [&queue](std::function<void()> Task) { queue.Post(std::move(Task)); };
+            std::vector<std::unique_ptr<mt::DataSource>> sources;
+            std::vector<std::unique_ptr<mt::FrameReader>> readers;
+            for (std::size_t i = 0; i < Options.sources; i++)
+            {
+                sources.push_back(std::make_unique<mt::DataSource>());
+                sources.back()->SetDecodeMode(mt::DecodeMode::SharedScheduler);
+                sources.back()->LoadFromFile(Filename, true, false);
+                readers.push_back(std::make_unique<mt::FrameReader>(*sources.back()));
+            }
+
+            uint64_t frames = 0;
+            std::size_t finished = 0;
+            int maxthreads = 0;
+            std::function<void(mt::FrameReader*)> readnext = [&](mt::FrameReader* Reader)
+            {
+                Reader->RequestNextFrame([&, Reader](mt::priv::VideoPacketPtr Frame)
+                {
+                    if (!Frame)
+                    {
+                        maxthreads = std::max(maxthreads, GetThreadCount());
+                        finished++;
+                        return;
+                    }
+                    frames++;
+                    readnext(Reader);
+                }, executor);
+            };
+
+            double cpustart = GetProcessCpuSeconds();
+            auto start = std::chrono::steady_clock::now();
+            for (auto& reader : readers)
+            {
+                readnext(reader.get());
+            }
+            queue.RunUntil([&]() { return finished == readers.size(); });
+            double seconds = ToSeconds(std::chrono::steady_clock::now() - start);
+            double cpuseconds = GetProcessCpuSeconds() - cpustart;
+
+            Writer.BeginObject();
+            Writer.Field("readers", readers.size());
+            Writer.Field("scheduler_workers", mt::DecodeScheduler::GetInstance().GetWorkerCount());
+            Writer.Field("max_threads", maxthreads);
+            Writer.Field("wall_seconds", seconds);
+            Writer.Field("cpu_seconds", cpuseconds);
+            Writer.Field("frames", frames);
+            Writer.Field("fps", seconds > 0 ? frames / seconds : 0.0);
+            Writer.EndObject();
+        }
+    }
+
+    void RunAsyncBenchmark(const Options& Options, JsonWriter& Writer)
+    {
+        ClipSpec spec("mpeg4_320x240_gop30_b0_2s", AV_CODEC_ID_MPEG4, 320, 240, 30, 0, 2);
+        std::string filename = PrepareClip(Options, spec);
+        if (filename.empty()) return;
+        Writer.Key("async_readers");
+        RunAsyncReaders(Options, filename, Writer);
+    }
+}
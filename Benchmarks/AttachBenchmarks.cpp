@@ -0,0 +1,82 @@
+#include "Scenarios.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace bench
+{
+    namespace
+    {
+        /// Plays one source from the render loop while a second thread keeps attaching and
+        /// destroying playbacks on it, the way a host opening and closing preview panes would.
+        /// Reports how long Update() takes and how many frames the decoder got out meanwhile,
+        /// the churn should show up in neither.
+        void RunAttachSession(const std::string& Filename, bool Churn, double Seconds, JsonWriter& Writer)
+        {
+            std::cerr << "attach: " << (Churn ? "attaching and detaching meanwhile" : "fixed playbacks") << std::endl;
+            mt::DataSource data;
+            if (!data.LoadFromFile(Filename, true, false)) return;
+            data.SetLooping(true);
+            mt::VideoPlayback video(data);
+            data.Play();
+
+            std::atomic<bool> running(true);
+            std::atomic<uint64_t> attaches(0);
+            std::thread churn([&]()
+            {
+                while (Churn && running)
+                {
+                    std::unique_ptr<mt::VideoPlayback> playback(new mt::VideoPlayback(data));
+                    std::this_thread::sleep_for(std::chrono::microseconds(200));
+                    playback.reset();
+                    attaches++;
+                }
+            });
+
+            std::vector<double> updates;
+            uint64_t decodedstart = data.GetStats().decodedvideoframes;
+            auto start = std::chrono::steady_clock::now();
+            auto end = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(Seconds));
+            while (std::chrono::steady_clock::now() < end)
+            {
+                auto updatestart = std::chrono::steady_clock::now();
+                data.Update();
+                updates.push_back(ToSeconds(std::chrono::steady_clock::now() - updatestart) * 1000000.0);
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+            double wallseconds = ToSeconds(std::chrono::steady_clock::now() - start);
+            uint64_t decoded = data.GetStats().decodedvideoframes - decodedstart;
+            running = false;
+            churn.join();
+
+            std::sort(updates.begin(), updates.end());
+            Writer.BeginObject();
+            Writer.Field("mode", Churn ? "churn" : "fixed");
+            Writer.Field("attaches_per_second", wallseconds > 0 ? attaches / wallseconds : 0.0);
+            Writer.Field("decoded_fps", wallseconds > 0 ? decoded / wallseconds : 0.0);
+            Writer.Field("update_p50_us", updates.empty() ? 0.0 : updates[updates.size() / 2]);
+            Writer.Field("update_p99_us", updates.empty() ? 0.0 : updates[updates.size() * 99 / 100]);
+            Writer.Field("update_max_us", updates.empty() ? 0.0 : updates.back());
+            Writer.EndObject();
+        }
+    }
+
+    void RunAttachBenchmark(const Options& Options, JsonWriter& Writer)
+    {
+        ClipSpec spec("mpeg4_640x360_gop30_b0", AV_CODEC_ID_MPEG4, 640, 360, 30, 0);
+        std::string filename = PrepareClip(Options, spec);
+        if (filename.empty()) return;
+        double seconds = Options.quick ? 2.0 : Options.seconds;
+        Writer.Key("attach");
+        Writer.BeginArray();
+        for (bool churn : { false, true })
+        {
+            RunAttachSession(filename, churn, seconds, Writer);
+        }
+        Writer.EndArray();
+    }
+}
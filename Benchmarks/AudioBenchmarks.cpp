@@ -0,0 +1,154 @@
+#include "Scenarios.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#define DRIFT_SETTLE_MS 1000
+
+namespace bench
+{
+    namespace
+    {
+        /// Drives AudioPlayback::ReadSamples like a device callback would: fixed size periods
+        /// on a steady clock, recording how long every callback took and how much was queued.
+        void RunSimulatedDevice(const std::string& Filename, std::size_t PeriodFrames, double Seconds, JsonWriter& Writer)
+        {
+            mt::DataSource data;
+            if (!data.LoadFromFile(Filename, false, true)) return;
+            mt::AudioPlayback audio(data);
+            int samplerate = audio.GetSampleRate();
+            std::cerr << "audio: period " << PeriodFrames << " frames at " << samplerate << "Hz" << std::endl;
+
+            std::vector<long long> callbacktimes;
+            std::vector<std::size_t> bufferedframes;
+            // reserve up front so the simulated callback never allocates
+            std::size_t expectedcallbacks = static_cast<std::size_t>(Seconds * samplerate / PeriodFrames) + 64;
+            callbacktimes.reserve(expectedcallbacks * 2);
+            bufferedframes.reserve(expectedcallbacks * 2);
+            SimulatedDevice device(audio, PeriodFrames, [&](std::chrono::steady_clock::duration CallbackTime)
+            {
+                callbacktimes.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(CallbackTime).count());
+                bufferedframes.push_back(audio.GetBufferedFrameCount());
+            });
+
+            data.Play();
+            auto end = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(Seconds));
+            while (std::chrono::steady_clock::now() < end && !data.IsEndofFileReached())
+            {
+                data.Update();
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+            device.Stop();
+
+            std::sort(callbacktimes.begin(), callbacktimes.end());
+            double averagebuffered = 0;
+            for (auto frames : bufferedframes)
+            {
+                averagebuffered += frames;
+            }
+            averagebuffered = bufferedframes.empty() ? 0 : averagebuffered / bufferedframes.size();
+
+            Writer.BeginObject();
+            Writer.Field("period_frames", PeriodFrames);
+            Writer.Field("sample_rate", samplerate);
+            Writer.Field("callbacks", callbacktimes.size());
+            Writer.Field("underruns", audio.GetUnderrunCount());
+            Writer.Field("consumed_frames", audio.GetConsumedFrameCount());
+            Writer.Field("callback_p50_ns", callbacktimes.empty() ? 0LL : callbacktimes[callbacktimes.size() / 2]);
+            Writer.Field("callback_p99_ns", callbacktimes.empty() ? 0LL : callbacktimes[callbacktimes.size() * 99 / 100]);
+            Writer.Field("callback_max_ns", callbacktimes.empty() ? 0LL : callbacktimes.back());
+            Writer.Field("average_latency_ms", samplerate > 0 ? averagebuffered * 1000.0 / samplerate : 0.0);
+            Writer.EndObject();
+        }
+
+        /// Plays a clip whose audio timestamps drift against its sample count into a sink whose
+        /// crystal runs fast, and tracks how far the presented video frame is from the audio
+        /// the sink is playing.  With the wall clock that error grows with the session, with the
+        /// audio master clock it has to stay within a frame once playback settled.
+        void RunDriftSession(const std::string& Filename, bool MasterClock, double SinkPpm, double Seconds, JsonWriter& Writer)
+        {
+            mt::DataSource data;
+            if (!data.LoadFromFile(Filename)) return;
+            mt::VideoPlayback video(data);
+            mt::AudioPlayback audio(data);
+            if (MasterClock) data.SetMasterClock(&audio);
+            std::cerr << "drift: " << (MasterClock ? "audio master" : "wall clock") << " for " << Seconds << "s" << std::endl;
+
+            SimulatedDevice device(audio, 256, SimulatedDevice::Hook(), SinkPpm);
+
+            data.Play();
+            long long maxerror = 0;
+            long long maxsettlederror = 0;
+            long long lasterror = 0;
+            auto settled = std::chrono::steady_clock::now() + std::chrono::milliseconds(DRIFT_SETTLE_MS);
+            auto end = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(Seconds));
+            while (std::chrono::steady_clock::now() < end && !data.IsEndofFileReached())
+            {
+                data.Update();
+                auto packet = video.GetLastPacket();
+                if (packet && audio.HasClock() && !data.IsEndofFileReached())
+                {
+                    lasterror = (packet->pts - audio.GetClock()).count();
+                    maxerror = std::max(maxerror, std::abs(lasterror));
+                    if (std::chrono::steady_clock::now() >= settled) maxsettlederror = std::max(maxsettlederror, std::abs(lasterror));
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+            device.Stop();
+
+            mt::DataSourceStats stats = data.GetStats();
+            long long frametime = data.GetVideoFrameTime().count();
+            bool passed = !MasterClock || Check(maxsettlederror <= frametime, "drift: A/V error of " + std::to_string(maxsettlederror) + "us under the audio master clock exceeds a frame of " + std::to_string(frametime) + "us");
+            Writer.BeginObject();
+            Writer.Field("clock", MasterClock ? "audio" : "wall");
+            Writer.Field("sink_ppm", SinkPpm);
+            Writer.Field("seconds", Seconds);
+            Writer.Field("max_av_error_us", maxerror);
+            Writer.Field("max_settled_av_error_us", maxsettlederror);
+            Writer.Field("final_av_error_us", lasterror);
+            Writer.Field("audio_drift_us", static_cast<long long>(stats.audiodrift.count()));
+            Writer.Field("drift_corrections", stats.audiodriftcorrections);
+            Writer.Field("resyncs", stats.audioresyncs);
+            Writer.Field("presented_frames", stats.presentedframes);
+            Writer.Field("dropped_frames", stats.droppedframes);
+            Writer.Field("underruns", audio.GetUnderrunCount());
+            Writer.Field("passed", passed);
+            Writer.EndObject();
+        }
+    }
+
+    void RunAudioBenchmark(const Options& Options, JsonWriter& Writer)
+    {
+        int seconds = static_cast<int>(std::max(Options.seconds, 2.0)) + 1;
+        ClipSpec spec("mpeg4_320x180_gop30_b0_" + std::to_string(seconds) + "s", AV_CODEC_ID_MPEG4, 320, 180, 30, 0, seconds, true);
+        std::string filename = PrepareClip(Options, spec);
+        if (filename.empty()) return;
+        Writer.Key("audio");
+        Writer.BeginArray();
+        for (std::size_t period : { 64, 256, 1024 })
+        {
+            RunSimulatedDevice(filename, period, Options.quick ? 2.0 : Options.seconds, Writer);
+        }
+        Writer.EndArray();
+    }
+
+    void RunDriftBenchmark(const Options& Options, JsonWriter& Writer)
+    {
+        // long enough for a 0.1% drift to add up to several frames
+        double seconds = Options.quick ? 5.0 : std::max(Options.seconds, 60.0);
+        ClipSpec spec("mpeg4_320x180_gop30_b0_drift1000ppm_" + std::to_string(static_cast<int>(seconds) + 2) + "s", AV_CODEC_ID_MPEG4, 320, 180, 30, 0, seconds + 2, true);
+        spec.audiodriftppm = 1000;
+        std::string filename = PrepareClip(Options, spec);
+        if (filename.empty()) return;
+        Writer.Key("drift");
+        Writer.BeginArray();
+        for (bool masterclock : { false, true })
+        {
+            RunDriftSession(filename, masterclock, 500.0, seconds, Writer);
+        }
+        Writer.EndArray();
+    }
+}
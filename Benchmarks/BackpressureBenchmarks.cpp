@@ -0,0 +1,89 @@
+#include "Scenarios.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+#define BACKPRESSURE_STARTUP_MS 500
+
+namespace bench
+{
+    namespace
+    {
+        /// Plays an interleaved clip into a simulated audio device while the video side only calls
+        /// Update every UpdateInterval, so its queue sits full in between.  With no parking space
+        /// the demuxer stops with the video queue and the device runs dry.  With the default parking
+        /// space the device must not run dry once playback started.
+        void RunSlowVideoConsumer(const std::string& Filename, std::size_t MaxParkedBytes, std::chrono::milliseconds UpdateInterval, double Seconds, JsonWriter& Writer)
+        {
+            mt::DataSource data;
+            if (!data.LoadFromFile(Filename)) return;
+            mt::QueueLimits limits = data.GetQueueLimits();
+            limits.maxparkedbytes = MaxParkedBytes;
+            data.SetQueueLimits(limits);
+            mt::VideoPlayback video(data);
+            mt::AudioPlayback audio(data);
+            std::cerr << "backpressure: parking " << MaxParkedBytes << " bytes, video update every " << UpdateInterval.count() << "ms" << std::endl;
+
+            SimulatedDevice device(audio, 256);
+
+            data.Play();
+            std::size_t peakpackets = 0;
+            std::size_t peakbytes = 0;
+            // underruns before the decoder first filled the ring are not what this is about
+            auto startup = std::chrono::steady_clock::now() + std::chrono::milliseconds(BACKPRESSURE_STARTUP_MS);
+            bool started = false;
+            uint64_t startupunderruns = 0;
+            auto nextupdate = std::chrono::steady_clock::now();
+            auto end = nextupdate + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(Seconds));
+            while (std::chrono::steady_clock::now() < end && !data.IsEndofFileReached())
+            {
+                if (std::chrono::steady_clock::now() >= nextupdate)
+                {
+                    data.Update();
+                    nextupdate += UpdateInterval;
+                }
+                if (!started && std::chrono::steady_clock::now() >= startup)
+                {
+                    started = true;
+                    startupunderruns = audio.GetUnderrunCount();
+                }
+                mt::DataSourceStats stats = data.GetStats();
+                peakpackets = std::max(peakpackets, stats.parkedpackets);
+                peakbytes = std::max(peakbytes, stats.parkedbytes);
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+            device.Stop();
+
+            uint64_t underruns = audio.GetUnderrunCount() - startupunderruns;
+            bool passed = MaxParkedBytes != mt::QueueLimits().maxparkedbytes || Check(started && underruns == 0, "backpressure: " + std::to_string(underruns) + " audio underruns after startup behind a slow video consumer");
+            Writer.BeginObject();
+            Writer.Field("max_parked_bytes", MaxParkedBytes);
+            Writer.Field("video_update_interval_ms", static_cast<long long>(UpdateInterval.count()));
+            Writer.Field("audio_underruns", audio.GetUnderrunCount());
+            Writer.Field("audio_underruns_after_startup", underruns);
+            Writer.Field("audio_consumed_frames", audio.GetConsumedFrameCount());
+            Writer.Field("presented_frames", video.GetStats().presentedframes);
+            Writer.Field("peak_parked_packets", peakpackets);
+            Writer.Field("peak_parked_bytes", peakbytes);
+            Writer.Field("passed", passed);
+            Writer.EndObject();
+        }
+    }
+
+    void RunBackpressureBenchmark(const Options& Options, JsonWriter& Writer)
+    {
+        double seconds = Options.quick ? 3.0 : std::min(Options.seconds, 10.0);
+        ClipSpec spec("mpeg4_640x360_gop30_b0_audio_" + std::to_string(static_cast<int>(seconds) + 2) + "s", AV_CODEC_ID_MPEG4, 640, 360, 30, 0, seconds + 2, true);
+        std::string filename = PrepareClip(Options, spec);
+        if (filename.empty()) return;
+        Writer.Key("backpressure");
+        Writer.BeginArray();
+        // zero parking space is the old behaviour, reading stops as soon as the video queue is full
+        for (std::size_t parked : { static_cast<std::size_t>(0), mt::QueueLimits().maxparkedbytes })
+        {
+            RunSlowVideoConsumer(filename, parked, std::chrono::milliseconds(500), seconds, Writer);
+        }
+        Writer.EndArray();
+    }
+}
@@ -0,0 +1,165 @@
+#include "BenchUtil.hpp"
+
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace bench
+{
+    namespace
+    {
+        int g_failedchecks = 0;
+    }
+
+    Options::Options() :
+        outputpath("motionless-bench.json"),
+        workdir("."),
+        seconds(10.0),
+        sources(200),
+        quick(false)
+    { }
+
+    std::string PrepareClip(const Options& Options, const ClipSpec& Spec)
+    {
+        std::string extension = Spec.container == "matroska" ? ".mkv" : "." + Spec.container;
+        std::string filename = Options.workdir + "/" + Spec.name + (Spec.audio ? "_audio" : "") + extension;
+        std::ifstream existing(filename);
+        if (existing.good()) return filename;
+        return GenerateClip(Spec, filename) ? filename : std::string();
+    }
+
+    bool PumpUntil(mt::DataSource& Source, const std::function<bool()>& Done, std::chrono::milliseconds Timeout)
+    {
+        auto deadline = std::chrono::steady_clock::now() + Timeout;
+        while (!Done())
+        {
+            if (std::chrono::steady_clock::now() > deadline) return false;
+            Source.Update();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    bool Check(bool Condition, const std::string& Description)
+    {
+        if (Condition) return true;
+        std::cerr << "check failed: " << Description << std::endl;
+        g_failedchecks++;
+        return false;
+    }
+
+    int GetFailedCheckCount()
+    {
+        return g_failedchecks;
+    }
+
+    SimulatedDevice::SimulatedDevice(mt::AudioPlayback& Audio, std::size_t PeriodFrames, Hook Callback, double SinkPpm) :
+        m_audio(Audio),
+        m_periodframes(PeriodFrames),
+        m_callback(Callback),
+        m_periodlength(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(PeriodFrames / (Audio.GetSampleRate() * (1.0 + SinkPpm / 1000000.0))))),
+        m_period(PeriodFrames * Audio.GetChannelCount()),
+        m_running(true),
+        m_thread()
+    {
+        m_thread = std::thread(&SimulatedDevice::Run, this);
+    }
+
+    SimulatedDevice::~SimulatedDevice()
+    {
+        Stop();
+    }
+
+    void SimulatedDevice::Stop()
+    {
+        m_running = false;
+        if (m_thread.joinable()) m_thread.join();
+    }
+
+    void SimulatedDevice::Run()
+    {
+        auto next = std::chrono::steady_clock::now();
+        while (m_running)
+        {
+            auto start = std::chrono::steady_clock::now();
+            m_audio.ReadSamples(m_period.data(), m_periodframes);
+            if (m_callback) m_callback(std::chrono::steady_clock::now() - start);
+            next += m_periodlength;
+            std::this_thread::sleep_until(next);
+        }
+    }
+
+    std::size_t GetResidentBytes()
+    {
+#ifdef __linux__
+        std::ifstream statm("/proc/self/statm");
+        std::size_t pages = 0;
+        std::size_t resident = 0;
+        statm >> pages >> resident;
+        return resident * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#else
+        return 0;
+#endif
+    }
+
+    uint64_t GetProcessReadBytes()
+    {
+#ifdef __linux__
+        std::ifstream io("/proc/self/io");
+        std::string line;
+        while (std::getline(io, line))
+        {
+            if (line.compare(0, 6, "rchar:") == 0) return std::stoull(line.substr(6));
+        }
+#endif
+        return 0;
+    }
+
+    int GetThreadCount()
+    {
+#ifdef __linux__
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line))
+        {
+            if (line.compare(0, 8, "Threads:") == 0) return std::stoi(line.substr(8));
+        }
+#endif
+        return -1;
+    }
+
+    double GetProcessCpuSeconds()
+    {
+#ifdef __linux__
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000000.0;
+#else
+        return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+#endif
+    }
+
+    double ToSeconds(std::chrono::steady_clock::duration Duration)
+    {
+        return std::chrono::duration_cast<std::chrono::duration<double>>(Duration).count();
+    }
+
+    void WriteHistogram(JsonWriter& Writer, const std::string& Name, const mt::TimeHistogram& Histogram)
+    {
+        Writer.Key(Name);
+        Writer.BeginObject();
+        Writer.Field("count", Histogram.count);
+        Writer.Field("total_us", Histogram.total.count());
+        Writer.Field("avg_us", Histogram.GetAverage().count());
+        Writer.Field("p50_us", Histogram.GetPercentile(50).count());
+        Writer.Field("p95_us", Histogram.GetPercentile(95).count());
+        Writer.Field("max_us", Histogram.max.count());
+        Writer.EndObject();
+    }
+}
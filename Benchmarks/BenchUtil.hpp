@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "include/Motion.hpp"
+#include "JsonWriter.hpp"
+#include "MediaGenerator.hpp"
+
+namespace bench
+{
+    class Options
+    {
+    public:
+        std::string outputpath;
+        std::string workdir;
+        double seconds;
+        std::size_t sources;
+        bool quick;
+
+        Options();
+    };
+
+    /// Generates the clip into the work directory unless it is already there, returns the
+    /// path or an empty string when the encoder is missing.
+    std::string PrepareClip(const Options& Options, const ClipSpec& Spec);
+
+    /// Calls Update() on the source about once per millisecond until Done returns true.
+    bool PumpUntil(mt::DataSource& Source, const std::function<bool()>& Done, std::chrono::milliseconds Timeout);
+
+    /// Drains an AudioPlayback on its own thread like a device callback would: PeriodFrames at a
+    /// time on a steady clock that runs SinkPpm fast.  Hook runs after every callback with the
+    /// time ReadSamples took.  Starts right away, stops with Stop() or the destructor.
+    class SimulatedDevice
+    {
+    public:
+        typedef std::function<void(std::chrono::steady_clock::duration)> Hook;
+
+        SimulatedDevice(mt::AudioPlayback& Audio, std::size_t PeriodFrames, Hook Callback = Hook(), double SinkPpm = 0.0);
+        ~SimulatedDevice();
+        void Stop();
+
+    private:
+        mt::AudioPlayback& m_audio;
+        std::size_t m_periodframes;
+        Hook m_callback;
+        std::chrono::steady_clock::duration m_periodlength;
+        std::vector<int16_t> m_period;
+        std::atomic<bool> m_running;
+        std::thread m_thread;
+
+        void Run();
+    };
+
+    /// Scenarios that double as tests check their results through this.  A failed check is
+    /// reported on stderr and main() exits non-zero once every scenario ran.
+    bool Check(bool Condition, const std::string& Description);
+    int GetFailedCheckCount();
+
+    std::size_t GetResidentBytes();
+    /// Bytes the process pulled through read calls, page cache hits included.
+    uint64_t GetProcessReadBytes();
+    int GetThreadCount();
+    double GetProcessCpuSeconds();
+    double ToSeconds(std::chrono::steady_clock::duration Duration);
+
+    void WriteHistogram(JsonWriter& Writer, const std::string& Name, const mt::TimeHistogram& Histogram);
+}
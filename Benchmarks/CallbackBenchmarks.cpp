@@ -0,0 +1,98 @@
+#include "Scenarios.hpp"
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#define CALLBACK_SOURCE_COUNT 64
+#define CALLBACK_PLAYING_EVERY 16
+
+namespace bench
+{
+    namespace
+    {
+        /// Renders many sources of which only a few play, the rest sit paused.  Polling updates
+        /// every source every tick; with callbacks a source is only updated after it reported a
+        /// new frame or a change of state and dropped again once it stops playing.
+        void RunCallbackSession(const std::string& Filename, bool Push, double Seconds, JsonWriter& Writer)
+        {
+            std::cerr << "callback: " << (Push ? "frame ready callbacks" : "polling") << std::endl;
+            std::vector<std::unique_ptr<mt::DataSource>> sources;
+            std::vector<std::unique_ptr<mt::VideoPlayback>> players;
+            std::unique_ptr<std::atomic<bool>[]> active(new std::atomic<bool>[CALLBACK_SOURCE_COUNT]);
+            for (std::size_t i = 0; i < CALLBACK_SOURCE_COUNT; i++)
+            {
+                active[i] = false;
+                sources.push_back(std::make_unique<mt::DataSource>());
+                mt::DataSource& source = *sources.back();
+                source.SetDecodeMode(mt::DecodeMode::SharedScheduler);
+                if (Push)
+                {
+                    std::atomic<bool>* flag = &active[i];
+                    source.SetFrameReadyCallback([flag](mt::DataSource&, std::chrono::microseconds) { *flag = true; });
+                    source.SetStateChangedCallback([flag](mt::DataSource&, mt::State, mt::State) { *flag = true; });
+                }
+                source.LoadFromFile(Filename, true, false);
+                players.push_back(std::make_unique<mt::VideoPlayback>(source));
+                if (i % CALLBACK_PLAYING_EVERY == 0) source.Play();
+            }
+
+            uint64_t ticks = 0;
+            uint64_t updates = 0;
+            std::chrono::steady_clock::duration updatetime(0);
+            auto start = std::chrono::steady_clock::now();
+            auto end = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(Seconds));
+            auto nextframe = start;
+            while (std::chrono::steady_clock::now() < end)
+            {
+                auto tickstart = std::chrono::steady_clock::now();
+                for (std::size_t i = 0; i < sources.size(); i++)
+                {
+                    mt::DataSource& source = *sources[i];
+                    // a playing source stays on the list until it stops, its frames come due between callbacks
+                    if (Push && !active[i] && source.GetState() != mt::State::Playing) continue;
+                    source.Update();
+                    updates++;
+                    if (source.GetState() == mt::State::Stopped && i % CALLBACK_PLAYING_EVERY == 0) source.Play();
+                    if (Push && source.GetState() != mt::State::Playing) active[i] = false;
+                }
+                updatetime += std::chrono::steady_clock::now() - tickstart;
+                ticks++;
+                nextframe += std::chrono::microseconds(16667);
+                std::this_thread::sleep_until(nextframe);
+            }
+
+            uint64_t presented = 0;
+            for (auto& source : sources)
+            {
+                presented += source->GetStats().presentedframes;
+            }
+            Writer.BeginObject();
+            Writer.Field("mode", Push ? "push" : "poll");
+            Writer.Field("sources", sources.size());
+            Writer.Field("playing_sources", (sources.size() + CALLBACK_PLAYING_EVERY - 1) / CALLBACK_PLAYING_EVERY);
+            Writer.Field("ticks", ticks);
+            Writer.Field("updates_per_tick", ticks > 0 ? static_cast<double>(updates) / ticks : 0.0);
+            Writer.Field("update_us_per_tick", ticks > 0 ? ToSeconds(updatetime) * 1000000.0 / ticks : 0.0);
+            Writer.Field("presented_frames", presented);
+            Writer.EndObject();
+        }
+    }
+
+    void RunCallbackBenchmark(const Options& Options, JsonWriter& Writer)
+    {
+        ClipSpec spec("mpeg4_320x240_gop30_b0", AV_CODEC_ID_MPEG4, 320, 240, 30, 0);
+        std::string filename = PrepareClip(Options, spec);
+        if (filename.empty()) return;
+        double seconds = Options.quick ? 2.0 : Options.seconds;
+        Writer.Key("callback");
+        Writer.BeginArray();
+        for (bool push : { false, true })
+        {
+            RunCallbackSession(filename, push, seconds, Writer);
+        }
+        Writer.EndArray();
+    }
+}
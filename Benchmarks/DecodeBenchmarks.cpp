@@ -0,0 +1,114 @@
+#include "Scenarios.hpp"
+
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace bench
+{
+    namespace
+    {
+        void RunClip(const ClipSpec& Spec, const std::string& Filename, JsonWriter& Writer)
+        {
+            std::cerr << "decode: " << Spec.name << std::endl;
+            auto loadstart = std::chrono::steady_clock::now();
+            mt::DataSource data;
+            if (!data.LoadFromFile(Filename, true, false)) return;
+            mt::VideoPlayback player(data);
+            data.Play();
+            bool gotframe = PumpUntil(data, [&]() { return player.GetLastPacket() != nullptr; }, std::chrono::seconds(5));
+            auto firstframe = std::chrono::steady_clock::now() - loadstart;
+            auto cliplength = std::chrono::duration_cast<std::chrono::milliseconds>(data.GetFileLength());
+            PumpUntil(data, [&]() { return data.IsEndofFileReached(); }, cliplength + std::chrono::seconds(5));
+            mt::DataSourceStats playstats = data.GetStats();
+
+            // seeks land on whole seconds, so alternate between the start and one second in
+            data.ResetStats();
+            const uint64_t seekcount = 4;
+            for (uint64_t i = 0; i < seekcount; i++)
+            {
+                data.SetPlayingOffset(std::chrono::seconds(i % 2));
+                PumpUntil(data, [&]() { return data.GetStats().seeklatency.count > i; }, std::chrono::seconds(2));
+            }
+            mt::DataSourceStats seekstats = data.GetStats();
+
+            double decodeseconds = playstats.decodetime.total.count() / 1000000.0;
+            double pipelineseconds = (playstats.readtime.total + playstats.decodetime.total + playstats.converttime.total + playstats.decodecopytime.total).count() / 1000000.0;
+            Writer.BeginObject();
+            Writer.Field("clip", Spec.name);
+            Writer.Field("codec", avcodec_get_name(Spec.codec));
+            Writer.Field("width", Spec.width);
+            Writer.Field("height", Spec.height);
+            Writer.Field("gop_size", Spec.gopsize);
+            Writer.Field("b_frames", Spec.bframes);
+            Writer.Field("time_to_first_frame_us", gotframe ? std::chrono::duration_cast<std::chrono::microseconds>(firstframe).count() : -1LL);
+            Writer.Field("decoded_frames", playstats.decodedvideoframes);
+            Writer.Field("decode_fps", decodeseconds > 0 ? playstats.decodedvideoframes / decodeseconds : 0.0);
+            Writer.Field("pipeline_fps", pipelineseconds > 0 ? playstats.convertedframes / pipelineseconds : 0.0);
+            Writer.Field("bytes_read", playstats.bytesread);
+            WriteHistogram(Writer, "read", playstats.readtime);
+            WriteHistogram(Writer, "decode", playstats.decodetime);
+            WriteHistogram(Writer, "convert", playstats.converttime);
+            WriteHistogram(Writer, "copy", playstats.decodecopytime);
+            WriteHistogram(Writer, "seek_latency", seekstats.seeklatency);
+            Writer.EndObject();
+        }
+    }
+
+    void RunDecodeBenchmarks(const Options& Options, JsonWriter& Writer)
+    {
+        Writer.Key("decode");
+        Writer.BeginArray();
+        for (auto& spec : GetDecodeMatrix(Options.quick))
+        {
+            std::string filename = PrepareClip(Options, spec);
+            if (filename.empty())
+            {
+                std::cerr << "decode: skipping " << spec.name << ", encoder unavailable" << std::endl;
+                continue;
+            }
+            RunClip(spec, filename, Writer);
+        }
+        Writer.EndArray();
+    }
+
+    void RunMemoryBenchmark(const Options& Options, JsonWriter& Writer)
+    {
+        const std::size_t sourcecount = 16;
+        ClipSpec spec("mpeg4_1280x720_gop60_b2", AV_CODEC_ID_MPEG4, 1280, 720, 60, 2);
+        std::string filename = PrepareClip(Options, spec);
+        if (filename.empty()) return;
+        std::cerr << "memory: " << sourcecount << " x " << spec.name << std::endl;
+
+        std::size_t residentbefore = GetResidentBytes();
+        std::vector<std::unique_ptr<mt::DataSource>> sources;
+        std::vector<std::unique_ptr<mt::VideoPlayback>> players;
+        for (std::size_t i = 0; i < sourcecount; i++)
+        {
+            sources.push_back(std::make_unique<mt::DataSource>());
+            sources.back()->LoadFromFile(filename, true, false);
+            players.push_back(std::make_unique<mt::VideoPlayback>(*sources.back()));
+        }
+        // wait for every decode queue to fill up before sampling
+        for (auto& source : sources)
+        {
+            PumpUntil(*source, [&]() { mt::DataSourceStats stats = source->GetStats(); return stats.queuedepthhighwater >= stats.videoqueuelimit; }, std::chrono::seconds(3));
+        }
+        std::size_t residentafter = GetResidentBytes();
+        mt::DataSourceStats stats = sources.front()->GetStats();
+
+        Writer.Key("memory");
+        Writer.BeginObject();
+        Writer.Field("clip", spec.name);
+        Writer.Field("sources", sourcecount);
+        Writer.Field("resident_before_bytes", residentbefore);
+        Writer.Field("resident_after_bytes", residentafter);
+        Writer.Field("bytes_per_source", residentafter > residentbefore ? (residentafter - residentbefore) / sourcecount : 0);
+        Writer.Field("queue_limit_frames", stats.videoqueuelimit);
+        Writer.Field("queue_target_us", stats.queuetarget.count());
+        Writer.Field("reported_bytes_per_source", stats.memorybytes);
+        Writer.Field("reported_staging_bytes", stats.stagingbytes);
+        Writer.Field("reported_video_queue_bytes", stats.videoqueuebytes);
+        Writer.EndObject();
+    }
+}
@@ -0,0 +1,89 @@
+#include "Scenarios.hpp"
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace bench
+{
+    namespace
+    {
+        /// Mirrors the frame and keeps its top left quarter the way an application would after
+        /// GetRGBABuffer(), a second full pass over every frame.
+        void MirrorAndCrop(const uint8_t* Source, int Width, int Height, int Stride, std::vector<uint8_t>& Destination)
+        {
+            int outputwidth = Width / 2;
+            int outputheight = Height / 2;
+            Destination.resize(static_cast<std::size_t>(outputwidth) * outputheight * 4);
+            for (int y = 0; y < outputheight; y++)
+            {
+                const uint8_t* row = Source + static_cast<std::size_t>(y) * Stride;
+                uint8_t* output = Destination.data() + static_cast<std::size_t>(y) * outputwidth * 4;
+                for (int x = 0; x < outputwidth; x++)
+                {
+                    std::memcpy(output + x * 4, row + (Width - 1 - x) * 4, 4);
+                }
+            }
+        }
+
+        /// Pulls every frame through a FrameReader, either post processed on the CPU or with the
+        /// same mirror and crop as a filter graph in front of the conversion.
+        void RunFiltered(const std::string& Filename, bool Graph, JsonWriter& Writer)
+        {
+            mt::DataSource data;
+            if (!data.LoadFromFile(Filename, true, false)) return;
+            if (Graph && !data.SetVideoFilter("hflip,crop=iw/2:ih/2:0:0")) return;
+            std::cerr << "filter: " << (Graph ? "filter graph" : "cpu after conversion") << std::endl;
+            mt::FrameReader reader(data);
+            std::vector<uint8_t> output;
+            uint64_t frames = 0;
+            int width = 0;
+            int height = 0;
+            double cpustart = GetProcessCpuSeconds();
+            auto start = std::chrono::steady_clock::now();
+            for (auto& frame : reader)
+            {
+                if (Graph)
+                {
+                    width = frame->width;
+                    height = frame->height;
+                }
+                else
+                {
+                    MirrorAndCrop(frame->GetRGBABuffer(), frame->width, frame->height, frame->stride, output);
+                    width = frame->width / 2;
+                    height = frame->height / 2;
+                }
+                frames++;
+            }
+            double seconds = ToSeconds(std::chrono::steady_clock::now() - start);
+            double cpuseconds = GetProcessCpuSeconds() - cpustart;
+            mt::DataSourceStats stats = data.GetStats();
+            Writer.BeginObject();
+            Writer.Field("mode", Graph ? "graph" : "cpu");
+            Writer.Field("frames", frames);
+            Writer.Field("output_width", width);
+            Writer.Field("output_height", height);
+            Writer.Field("wall_seconds", seconds);
+            Writer.Field("cpu_seconds", cpuseconds);
+            Writer.Field("fps", seconds > 0 ? frames / seconds : 0.0);
+            Writer.Field("convert_avg_us", static_cast<long long>(stats.converttime.GetAverage().count()));
+            Writer.Field("copy_avg_us", static_cast<long long>(stats.decodecopytime.GetAverage().count()));
+            Writer.EndObject();
+        }
+    }
+
+    void RunFilterBenchmark(const Options& Options, JsonWriter& Writer)
+    {
+        ClipSpec spec("mpeg4_1920x1080_gop30_b0", AV_CODEC_ID_MPEG4, 1920, 1080, 30, 0);
+        std::string filename = PrepareClip(Options, spec);
+        if (filename.empty()) return;
+        Writer.Key("filter");
+        Writer.BeginArray();
+        for (bool graph : { false, true })
+        {
+            RunFiltered(filename, graph, Writer);
+        }
+        Writer.EndArray();
+    }
+}
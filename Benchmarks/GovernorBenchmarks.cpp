@@ -0,0 +1,90 @@
+#include "Scenarios.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace bench
+{
+    namespace
+    {
+        /// Plays Count sources, every other one at low priority, under the given memory cap and
+        /// samples the governor's total while they run.
+        void RunCapped(const std::string& Filename, std::size_t Count, std::size_t Limit, double Seconds, const char* Name, JsonWriter& Writer)
+        {
+            std::cerr << "governor: " << Name << ", cap " << Limit << " bytes" << std::endl;
+            mt::MemoryGovernor& governor = mt::MemoryGovernor::GetInstance();
+            governor.SetLimit(Limit);
+            std::vector<std::unique_ptr<mt::DataSource>> sources;
+            std::vector<std::unique_ptr<mt::VideoPlayback>> players;
+            for (std::size_t i = 0; i < Count; i++)
+            {
+                sources.push_back(std::make_unique<mt::DataSource>());
+                sources.back()->SetPriority(i % 2 == 0 ? mt::DecodePriority::Normal : mt::DecodePriority::Low);
+                sources.back()->LoadFromFile(Filename, true, false);
+                players.push_back(std::make_unique<mt::VideoPlayback>(*sources.back()));
+                sources.back()->Play();
+            }
+
+            std::size_t peak = 0;
+            std::size_t overlimitsamples = 0;
+            std::size_t samples = 0;
+            auto end = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(Seconds));
+            while (std::chrono::steady_clock::now() < end)
+            {
+                for (auto& source : sources)
+                {
+                    source->Update();
+                    if (source->GetState() == mt::State::Stopped) source->Play();
+                }
+                peak = std::max(peak, governor.GetUsedBytes());
+                if (governor.IsOverLimit()) overlimitsamples++;
+                samples++;
+                std::this_thread::sleep_for(std::chrono::milliseconds(16));
+            }
+
+            uint64_t presented[2] = { 0, 0 };
+            for (auto& source : sources)
+            {
+                presented[source->GetPriority() == mt::DecodePriority::Low ? 1 : 0] += source->GetStats().presentedframes;
+            }
+            std::vector<mt::SourceMemory> breakdown = governor.GetBreakdown();
+            std::size_t largest = 0;
+            for (auto& memory : breakdown)
+            {
+                largest = std::max(largest, memory.totalbytes);
+            }
+
+            Writer.BeginObject();
+            Writer.Field("case", Name);
+            Writer.Field("sources", Count);
+            Writer.Field("limit_bytes", Limit);
+            Writer.Field("peak_used_bytes", peak);
+            Writer.Field("over_limit_fraction", samples ? static_cast<double>(overlimitsamples) / samples : 0.0);
+            Writer.Field("normal_priority_presented_frames", presented[0]);
+            Writer.Field("low_priority_presented_frames", presented[1]);
+            Writer.Field("accounts", breakdown.size());
+            Writer.Field("largest_source_bytes", largest);
+            Writer.EndObject();
+            governor.SetLimit(0);
+        }
+    }
+
+    void RunGovernorBenchmark(const Options& Options, JsonWriter& Writer)
+    {
+        ClipSpec spec("mpeg4_1280x720_gop60_b2", AV_CODEC_ID_MPEG4, 1280, 720, 60, 2);
+        std::string filename = PrepareClip(Options, spec);
+        if (filename.empty()) return;
+        std::size_t count = Options.quick ? 8 : 16;
+        double seconds = Options.quick ? 2.0 : std::min(Options.seconds, 6.0);
+        // about four frames per source, well under what the default queue limits would take
+        std::size_t framebytes = static_cast<std::size_t>(spec.width) * spec.height * 4;
+        Writer.Key("governor");
+        Writer.BeginArray();
+        RunCapped(filename, count, 0, seconds, "uncapped", Writer);
+        RunCapped(filename, count, count * framebytes * 4, seconds, "capped", Writer);
+        Writer.EndArray();
+    }
+}
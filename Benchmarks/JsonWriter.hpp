@@ -0,0 +1,122 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace bench
+{
+    /// Minimal streaming JSON writer, just enough to keep the result files machine readable.
+    class JsonWriter
+    {
+    private:
+        std::ostream& m_stream;
+        std::vector<bool> m_firstinscope;
+        bool m_afterkey;
+
+        void Prefix()
+        {
+            if (m_afterkey)
+            {
+                m_afterkey = false;
+                return;
+            }
+            if (!m_firstinscope.empty())
+            {
+                if (!m_firstinscope.back()) m_stream << ",";
+                m_firstinscope.back() = false;
+                m_stream << "\n" << std::string(m_firstinscope.size() * 2, ' ');
+            }
+        }
+
+        void WriteString(const std::string& Text)
+        {
+            m_stream << '"';
+            for (char c : Text)
+            {
+                if (c == '"' || c == '\\') m_stream << '\\';
+                m_stream << c;
+            }
+            m_stream << '"';
+        }
+
+    public:
+        JsonWriter(std::ostream& Stream) :
+            m_stream(Stream),
+            m_firstinscope(),
+            m_afterkey(false)
+        { }
+
+        void BeginObject()
+        {
+            Prefix();
+            m_stream << "{";
+            m_firstinscope.push_back(true);
+        }
+
+        void EndObject()
+        {
+            m_firstinscope.pop_back();
+            m_stream << "\n" << std::string(m_firstinscope.size() * 2, ' ') << "}";
+        }
+
+        void BeginArray()
+        {
+            Prefix();
+            m_stream << "[";
+            m_firstinscope.push_back(true);
+        }
+
+        void EndArray()
+        {
+            m_firstinscope.pop_back();
+            m_stream << "\n" << std::string(m_firstinscope.size() * 2, ' ') << "]";
+        }
+
+        void Key(const std::string& Name)
+        {
+            Prefix();
+            WriteString(Name);
+            m_stream << ": ";
+            m_afterkey = true;
+        }
+
+        void Value(const std::string& Text)
+        {
+            Prefix();
+            WriteString(Text);
+        }
+
+        void Value(const char* Text)
+        {
+            Value(std::string(Text));
+        }
+
+        void Value(bool Flag)
+        {
+            Prefix();
+            m_stream << (Flag ? "true" : "false");
+        }
+
+        void Value(double Number)
+        {
+            Prefix();
+            m_stream << Number;
+        }
+
+        template <typename T>
+        typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type Value(T Number)
+        {
+            Prefix();
+            m_stream << Number;
+        }
+
+        template <typename T>
+        void Field(const std::string& Name, T FieldValue)
+        {
+            Key(Name);
+            Value(FieldValue);
+        }
+    };
+}
@@ -0,0 +1,80 @@
+#include "Scenarios.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace bench
+{
+    namespace
+    {
+        /// Plays a short clip over and over, either the way applications used to (rewinding once
+        /// the end is reached) or in loop mode, and measures the wall time between consecutive
+        /// frames reaching the screen.  The hitch at the loop point shows up as the largest gap.
+        void RunLoopSession(const std::string& Filename, bool LoopMode, double Seconds, JsonWriter& Writer)
+        {
+            mt::DataSource data;
+            if (!data.LoadFromFile(Filename, true, false)) return;
+            mt::VideoPlayback video(data);
+            std::cerr << "loop: " << (LoopMode ? "loop mode" : "rewind at the end") << std::endl;
+            data.SetLooping(LoopMode);
+            data.Play();
+
+            std::vector<double> gaps;
+            auto lastpts = std::chrono::microseconds::min();
+            auto lastchange = std::chrono::steady_clock::now();
+            uint64_t rewinds = 0;
+            auto end = lastchange + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(Seconds));
+            while (std::chrono::steady_clock::now() < end)
+            {
+                data.Update();
+                if (!LoopMode && data.IsEndofFileReached())
+                {
+                    data.SetPlayingOffset(std::chrono::microseconds(0));
+                    data.Play();
+                    rewinds++;
+                }
+                auto packet = video.GetLastPacket();
+                auto now = std::chrono::steady_clock::now();
+                // loop passes keep counting their timestamps up, so every new frame has a new one
+                if (packet && packet->pts != lastpts)
+                {
+                    if (lastpts != std::chrono::microseconds::min()) gaps.push_back(ToSeconds(now - lastchange) * 1000.0);
+                    lastpts = packet->pts;
+                    lastchange = now;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+
+            double frametime = data.GetVideoFrameTime().count() / 1000.0;
+            std::size_t hitches = static_cast<std::size_t>(std::count_if(gaps.begin(), gaps.end(), [&](double Gap) { return Gap > frametime * 2; }));
+            std::sort(gaps.begin(), gaps.end());
+            Writer.BeginObject();
+            Writer.Field("mode", LoopMode ? "loop" : "rewind");
+            Writer.Field("frames", gaps.size() + 1);
+            Writer.Field("loop_wraps", LoopMode ? data.GetStats().loopwraps : rewinds);
+            Writer.Field("frame_time_ms", frametime);
+            Writer.Field("gap_p50_ms", gaps.empty() ? 0.0 : gaps[gaps.size() / 2]);
+            Writer.Field("gap_p99_ms", gaps.empty() ? 0.0 : gaps[gaps.size() * 99 / 100]);
+            Writer.Field("gap_max_ms", gaps.empty() ? 0.0 : gaps.back());
+            Writer.Field("gaps_over_two_frames", hitches);
+            Writer.EndObject();
+        }
+    }
+
+    void RunLoopBenchmark(const Options& Options, JsonWriter& Writer)
+    {
+        ClipSpec spec("mpeg4_1280x720_gop60_b2", AV_CODEC_ID_MPEG4, 1280, 720, 60, 2);
+        std::string filename = PrepareClip(Options, spec);
+        if (filename.empty()) return;
+        double seconds = Options.quick ? 5.0 : std::max(Options.seconds, 10.0);
+        Writer.Key("loop");
+        Writer.BeginArray();
+        for (bool loopmode : { false, true })
+        {
+            RunLoopSession(filename, loopmode, seconds, Writer);
+        }
+        Writer.EndArray();
+    }
+}
@@ -0,0 +1,86 @@
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "Scenarios.hpp"
+
+namespace
+{
+    void PrintUsage()
+    {
+        std::cerr << "usage: motionless-bench [--output file.json|-] [--workdir dir] [--seconds n] [--sources n] [--quick]" << std::endl;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bench::Options options;
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasvalue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--output") == 0 && hasvalue) options.outputpath = argv[++i];
+        else if (std::strcmp(argv[i], "--workdir") == 0 && hasvalue) options.workdir = argv[++i];
+        else if (std::strcmp(argv[i], "--seconds") == 0 && hasvalue) options.seconds = std::stod(argv[++i]);
+        else if (std::strcmp(argv[i], "--sources") == 0 && hasvalue) options.sources = std::stoul(argv[++i]);
+        else if (std::strcmp(argv[i], "--quick") == 0) options.quick = true;
+        else
+        {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    av_register_all();
+    av_log_set_level(AV_LOG_ERROR);
+
+    std::ofstream file;
+    bool tostdout = options.outputpath == "-";
+    if (!tostdout)
+    {
+        file.open(options.outputpath, std::ios::out | std::ios::trunc);
+        if (!file)
+        {
+            std::cerr << "Benchmark: Failed to open output file: '" << options.outputpath << "'" << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& output = tostdout ? std::cout : file;
+
+    bench::JsonWriter writer(output);
+    writer.BeginObject();
+    writer.Field("suite", "motionless");
+    writer.Field("schema", 1);
+    writer.Field("timestamp", static_cast<long long>(std::time(nullptr)));
+    writer.Field("avcodec_version", avcodec_version());
+    writer.Field("quick", options.quick);
+    writer.Key("scenarios");
+    writer.BeginObject();
+    bench::RunDecodeBenchmarks(options, writer);
+    bench::RunMemoryBenchmark(options, writer);
+    bench::RunSchedulerStress(options, writer);
+    bench::RunAudioBenchmark(options, writer);
+    bench::RunDriftBenchmark(options, writer);
+    bench::RunSpeedBenchmark(options, writer);
+    bench::RunReverseBenchmark(options, writer);
+    bench::RunScrubBenchmark(options, writer);
+    bench::RunOfflineBenchmark(options, writer);
+    bench::RunAsyncBenchmark(options, writer);
+    bench::RunGovernorBenchmark(options, writer);
+    bench::RunTrackBenchmark(options, writer);
+    bench::RunBackpressureBenchmark(options, writer);
+    bench::RunFilterBenchmark(options, writer);
+    bench::RunRegionBenchmark(options, writer);
+    bench::RunLoopBenchmark(options, writer);
+    bench::RunPlaylistBenchmark(options, writer);
+    bench::RunSinkBenchmark(options, writer);
+    bench::RunAlignmentBenchmark(options, writer);
+    bench::RunCallbackBenchmark(options, writer);
+    bench::RunReadyFdBenchmark(options, writer);
+    bench::RunAttachBenchmark(options, writer);
+    writer.EndObject();
+    writer.EndObject();
+    output << std::endl;
+    return bench::GetFailedCheckCount() > 0 ? 1 : 0;
+}
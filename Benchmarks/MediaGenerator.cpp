@@ -0,0 +1,228 @@
+#include "MediaGenerator.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+
+extern "C"
+{
+#include <libavformat/avformat.h>
+#include <libavutil/channel_layout.h>
+#include <libavutil/pixdesc.h>
+}
+
+namespace bench
+{
+    ClipSpec::ClipSpec(const std::string& Name, AVCodecID Codec, int Width, int Height, int GopSize, int BFrames, double Seconds, bool Audio) :
+        name(Name),
+        codec(Codec),
+        width(Width),
+        height(Height),
+        framerate(30),
+        gopsize(GopSize),
+        bframes(BFrames),
+        seconds(Seconds),
+        audio(Audio),
+        audiodriftppm(0),
+        container("matroska")
+    { }
+
+    namespace
+    {
+        class Encoder
+        {
+        public:
+            AVCodecContext* context;
+            AVStream* stream;
+            AVFrame* frame;
+            int64_t nextpts;
+
+            Encoder() :
+                context(nullptr),
+                stream(nullptr),
+                frame(nullptr),
+                nextpts(0)
+            { }
+
+            ~Encoder()
+            {
+                if (frame) av_frame_free(&frame);
+                if (context) avcodec_free_context(&context);
+            }
+        };
+
+        bool WritePackets(AVFormatContext* FormatContext, Encoder& Encoder)
+        {
+            AVPacket* packet = av_packet_alloc();
+            int result = 0;
+            while ((result = avcodec_receive_packet(Encoder.context, packet)) == 0)
+            {
+                av_packet_rescale_ts(packet, Encoder.context->time_base, Encoder.stream->time_base);
+                packet->stream_index = Encoder.stream->index;
+                if (av_interleaved_write_frame(FormatContext, packet) < 0)
+                {
+                    av_packet_free(&packet);
+                    return false;
+                }
+            }
+            av_packet_free(&packet);
+            return result == AVERROR(EAGAIN) || result == AVERROR_EOF;
+        }
+
+        bool OpenVideo(AVFormatContext* FormatContext, const ClipSpec& Spec, Encoder& Encoder)
+        {
+            AVCodec* codec = avcodec_find_encoder(Spec.codec);
+            if (!codec) return false;
+            Encoder.stream = avformat_new_stream(FormatContext, nullptr);
+            Encoder.context = avcodec_alloc_context3(codec);
+            if (!Encoder.stream || !Encoder.context) return false;
+            Encoder.context->width = Spec.width;
+            Encoder.context->height = Spec.height;
+            Encoder.context->time_base = AVRational{ 1, Spec.framerate };
+            Encoder.context->framerate = AVRational{ Spec.framerate, 1 };
+            Encoder.context->pix_fmt = codec->pix_fmts ? codec->pix_fmts[0] : AV_PIX_FMT_YUV420P;
+            Encoder.context->gop_size = Spec.gopsize;
+            Encoder.context->max_b_frames = Spec.bframes;
+            Encoder.context->bit_rate = static_cast<int64_t>(Spec.width) * Spec.height * Spec.framerate / 8;
+            if (FormatContext->oformat->flags & AVFMT_GLOBALHEADER) Encoder.context->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+            if (avcodec_open2(Encoder.context, codec, nullptr) < 0) return false;
+            if (avcodec_parameters_from_context(Encoder.stream->codecpar, Encoder.context) < 0) return false;
+            Encoder.stream->time_base = Encoder.context->time_base;
+            Encoder.frame = av_frame_alloc();
+            Encoder.frame->format = Encoder.context->pix_fmt;
+            Encoder.frame->width = Spec.width;
+            Encoder.frame->height = Spec.height;
+            return av_frame_get_buffer(Encoder.frame, 32) == 0;
+        }
+
+        bool OpenAudio(AVFormatContext* FormatContext, Encoder& Encoder)
+        {
+            AVCodec* codec = avcodec_find_encoder(AV_CODEC_ID_MP2);
+            if (!codec) return false;
+            Encoder.stream = avformat_new_stream(FormatContext, nullptr);
+            Encoder.context = avcodec_alloc_context3(codec);
+            if (!Encoder.stream || !Encoder.context) return false;
+            Encoder.context->sample_fmt = AV_SAMPLE_FMT_S16;
+            Encoder.context->sample_rate = 48000;
+            Encoder.context->channel_layout = AV_CH_LAYOUT_STEREO;
+            Encoder.context->channels = 2;
+            Encoder.context->bit_rate = 192000;
+            Encoder.context->time_base = AVRational{ 1, Encoder.context->sample_rate };
+            if (FormatContext->oformat->flags & AVFMT_GLOBALHEADER) Encoder.context->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+            if (avcodec_open2(Encoder.context, codec, nullptr) < 0) return false;
+            if (avcodec_parameters_from_context(Encoder.stream->codecpar, Encoder.context) < 0) return false;
+            Encoder.stream->time_base = Encoder.context->time_base;
+            Encoder.frame = av_frame_alloc();
+            Encoder.frame->format = Encoder.context->sample_fmt;
+            Encoder.frame->channel_layout = Encoder.context->channel_layout;
+            Encoder.frame->sample_rate = Encoder.context->sample_rate;
+            Encoder.frame->nb_samples = Encoder.context->frame_size;
+            return av_frame_get_buffer(Encoder.frame, 0) == 0;
+        }
+
+        void FillPicture(AVFrame* Frame, int64_t Index)
+        {
+            const AVPixFmtDescriptor* descriptor = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(Frame->format));
+            for (int plane = 0; plane < 3 && Frame->data[plane]; plane++)
+            {
+                int width = plane == 0 ? Frame->width : AV_CEIL_RSHIFT(Frame->width, descriptor->log2_chroma_w);
+                int height = plane == 0 ? Frame->height : AV_CEIL_RSHIFT(Frame->height, descriptor->log2_chroma_h);
+                for (int y = 0; y < height; y++)
+                {
+                    uint8_t* row = Frame->data[plane] + y * Frame->linesize[plane];
+                    for (int x = 0; x < width; x++)
+                    {
+                        row[x] = plane == 0 ? static_cast<uint8_t>(x + y + Index * 3) : static_cast<uint8_t>(128 + ((x * plane + Index) & 63));
+                    }
+                }
+            }
+        }
+
+        void FillSamples(AVFrame* Frame, int64_t FirstSample)
+        {
+            int16_t* samples = reinterpret_cast<int16_t*>(Frame->data[0]);
+            for (int i = 0; i < Frame->nb_samples; i++)
+            {
+                double time = static_cast<double>(FirstSample + i) / Frame->sample_rate;
+                int16_t value = static_cast<int16_t>(std::sin(2.0 * 3.14159265358979 * 440.0 * time) * 8000.0);
+                samples[i * 2] = value;
+                samples[i * 2 + 1] = value;
+            }
+        }
+    }
+
+    bool GenerateClip(const ClipSpec& Spec, const std::string& Filename)
+    {
+        AVFormatContext* formatcontext = nullptr;
+        if (avformat_alloc_output_context2(&formatcontext, nullptr, Spec.container.c_str(), Filename.c_str()) < 0) return false;
+        Encoder video;
+        Encoder audio;
+        bool success = OpenVideo(formatcontext, Spec, video) && (!Spec.audio || OpenAudio(formatcontext, audio));
+        success = success && avio_open(&formatcontext->pb, Filename.c_str(), AVIO_FLAG_WRITE) >= 0;
+        success = success && avformat_write_header(formatcontext, nullptr) >= 0;
+        int64_t framecount = static_cast<int64_t>(Spec.seconds * Spec.framerate);
+        while (success && video.nextpts < framecount)
+        {
+            // keep the audio track interleaved slightly ahead of the video
+            bool audiofirst = Spec.audio && av_compare_ts(audio.nextpts, audio.context->time_base, video.nextpts, video.context->time_base) <= 0;
+            Encoder& encoder = audiofirst ? audio : video;
+            success = av_frame_make_writable(encoder.frame) >= 0;
+            if (!success) break;
+            if (audiofirst) FillSamples(encoder.frame, encoder.nextpts);
+            else FillPicture(encoder.frame, encoder.nextpts);
+            encoder.frame->pts = encoder.nextpts;
+            if (audiofirst) encoder.frame->pts += encoder.nextpts * Spec.audiodriftppm / 1000000;
+            encoder.nextpts += audiofirst ? encoder.frame->nb_samples : 1;
+            success = avcodec_send_frame(encoder.context, encoder.frame) >= 0 && WritePackets(formatcontext, encoder);
+        }
+        if (success)
+        {
+            avcodec_send_frame(video.context, nullptr);
+            success = WritePackets(formatcontext, video);
+            if (Spec.audio)
+            {
+                avcodec_send_frame(audio.context, nullptr);
+                success = success && WritePackets(formatcontext, audio);
+            }
+            success = success && av_write_trailer(formatcontext) == 0;
+        }
+        if (formatcontext->pb) avio_closep(&formatcontext->pb);
+        avformat_free_context(formatcontext);
+        if (!success) std::cout << "Benchmark: Failed to generate clip '" << Spec.name << "'" << std::endl;
+        return success;
+    }
+
+    std::vector<ClipSpec> GetDecodeMatrix(bool Quick)
+    {
+        struct Resolution { int width, height; };
+        struct GopLayout { int gopsize, bframes; };
+        std::vector<AVCodecID> codecs = { AV_CODEC_ID_MPEG4, AV_CODEC_ID_MPEG2VIDEO, AV_CODEC_ID_H264, AV_CODEC_ID_MJPEG };
+        std::vector<Resolution> resolutions = { { 320, 180 }, { 1280, 720 }, { 1920, 1080 } };
+        std::vector<GopLayout> layouts = { { 1, 0 }, { 12, 0 }, { 60, 2 } };
+        if (Quick)
+        {
+            codecs = { AV_CODEC_ID_MPEG4, AV_CODEC_ID_MJPEG };
+            resolutions = { { 640, 360 } };
+            layouts = { { 60, 2 } };
+        }
+        std::vector<ClipSpec> matrix;
+        for (auto codec : codecs)
+        {
+            for (auto& resolution : resolutions)
+            {
+                for (auto& layout : layouts)
+                {
+                    // intra only codecs have no GOP structure to vary
+                    bool intraonly = codec == AV_CODEC_ID_MJPEG;
+                    if (intraonly && layout.gopsize != layouts.back().gopsize) continue;
+                    GopLayout used = intraonly ? GopLayout{ 1, 0 } : layout;
+                    std::ostringstream name;
+                    name << avcodec_get_name(codec) << "_" << resolution.width << "x" << resolution.height << "_gop" << used.gopsize << "_b" << used.bframes;
+                    matrix.emplace_back(name.str(), codec, resolution.width, resolution.height, used.gopsize, used.bframes);
+                }
+            }
+        }
+        return matrix;
+    }
+}
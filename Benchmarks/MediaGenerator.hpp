@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+}
+
+namespace bench
+{
+    /// Description of a synthetic clip, encoded with FFmpeg's own encoders so the suite never
+    /// needs to download media.  The picture is a moving gradient so every frame differs.
+    class ClipSpec
+    {
+    public:
+        std::string name;
+        AVCodecID codec;
+        int width;
+        int height;
+        int framerate;
+        int gopsize;
+        int bframes;
+        double seconds;
+        bool audio;
+        /// Audio timestamps run this many parts per million faster than the samples, zero by default.
+        int audiodriftppm;
+        /// Muxer name, matroska by default.
+        std::string container;
+
+        ClipSpec(const std::string& Name, AVCodecID Codec, int Width, int Height, int GopSize, int BFrames, double Seconds = 2.0, bool Audio = false);
+    };
+
+    /// Encodes the clip into a file of the spec's container, returns false when the encoder is not available
+    /// in the linked FFmpeg build or anything fails along the way.
+    bool GenerateClip(const ClipSpec& Spec, const std::string& Filename);
+
+    /// Builds the codec x resolution x GOP layout matrix used by the decode benchmarks.
+    std::vector<ClipSpec> GetDecodeMatrix(bool Quick);
+}
@@ -0,0 +1,88 @@
+#include "Scenarios.hpp"
+
+#include <iostream>
+#include <thread>
+
+namespace bench
+{
+    namespace
+    {
+        /// Pulls every frame through a FrameReader as fast as it decodes and checks that none
+        /// were skipped or came out of order.
+        void RunOffline(const std::string& Filename, JsonWriter& Writer)
+        {
+            mt::DataSource data;
+            if (!data.LoadFromFile(Filename, true, false)) return;
+            std::cerr << "offline: frame reader" << std::endl;
+            mt::FrameReader reader(data);
+            uint64_t frames = 0;
+            uint64_t outoforder = 0;
+            auto lastpts = std::chrono::microseconds::min();
+            double cpustart = GetProcessCpuSeconds();
+            auto start = std::chrono::steady_clock::now();
+            for (auto& frame : reader)
+            {
+                if (frame->pts <= lastpts) outoforder++;
+                lastpts = frame->pts;
+                frames++;
+            }
+            double seconds = ToSeconds(std::chrono::steady_clock::now() - start);
+            double cpuseconds = GetProcessCpuSeconds() - cpustart;
+            mt::DataSourceStats stats = data.GetStats();
+            double mediaseconds = data.GetFileLength().count() / 1000000.0;
+            Writer.BeginObject();
+            Writer.Field("mode", "offline");
+            Writer.Field("wall_seconds", seconds);
+            Writer.Field("cpu_seconds", cpuseconds);
+            Writer.Field("frames", frames);
+            Writer.Field("fps", seconds > 0 ? frames / seconds : 0.0);
+            Writer.Field("realtime_factor", seconds > 0 ? mediaseconds / seconds : 0.0);
+            Writer.Field("decoded_video_frames", stats.decodedvideoframes);
+            Writer.Field("missing_frames", stats.decodedvideoframes - frames);
+            Writer.Field("out_of_order_frames", outoforder);
+            Writer.EndObject();
+        }
+
+        /// The same clip played to the end on the wall clock as the baseline.
+        void RunRealtime(const std::string& Filename, JsonWriter& Writer)
+        {
+            mt::DataSource data;
+            if (!data.LoadFromFile(Filename, true, false)) return;
+            mt::VideoPlayback video(data);
+            std::cerr << "offline: realtime baseline" << std::endl;
+            data.Play();
+            double cpustart = GetProcessCpuSeconds();
+            auto start = std::chrono::steady_clock::now();
+            while (!data.IsEndofFileReached())
+            {
+                data.Update();
+                std::this_thread::sleep_for(std::chrono::milliseconds(4));
+            }
+            double seconds = ToSeconds(std::chrono::steady_clock::now() - start);
+            double cpuseconds = GetProcessCpuSeconds() - cpustart;
+            mt::DataSourceStats stats = data.GetStats();
+            Writer.BeginObject();
+            Writer.Field("mode", "realtime");
+            Writer.Field("wall_seconds", seconds);
+            Writer.Field("cpu_seconds", cpuseconds);
+            Writer.Field("frames", stats.presentedframes);
+            Writer.Field("fps", seconds > 0 ? stats.presentedframes / seconds : 0.0);
+            Writer.Field("decoded_video_frames", stats.decodedvideoframes);
+            Writer.Field("dropped_frames", stats.droppedframes);
+            Writer.EndObject();
+        }
+    }
+
+    void RunOfflineBenchmark(const Options& Options, JsonWriter& Writer)
+    {
+        int seconds = Options.quick ? 3 : 10;
+        ClipSpec spec("mpeg4_640x360_gop30_b2_" + std::to_string(seconds) + "s", AV_CODEC_ID_MPEG4, 640, 360, 30, 2, seconds);
+        std::string filename = PrepareClip(Options, spec);
+        if (filename.empty()) return;
+        Writer.Key("offline");
+        Writer.BeginArray();
+        RunOffline(filename, Writer);
+        RunRealtime(filename, Writer);
+        Writer.EndArray();
+    }
+}
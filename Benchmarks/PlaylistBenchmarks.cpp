@@ -0,0 +1,132 @@
+#include "Scenarios.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace bench
+{
+    namespace
+    {
+        /// Plays the items back to back, either the way applications used to (loading the next
+        /// file into the same source once the current one ends) or through a Playlist, and
+        /// measures the wall time between the last frame of an item and the first of the next.
+        /// A preloaded switch has to come within one frame time of the regular frame interval and
+        /// must not be counted as a late transition.
+        void RunPlaylistSession(const std::vector<std::string>& Items, bool Preload, JsonWriter& Writer)
+        {
+            std::cerr << "playlist: " << (Preload ? "playlist" : "reload at the end") << std::endl;
+            mt::DataSource data;
+            mt::VideoPlayback video(data);
+            mt::Playlist playlist(true, false);
+            std::size_t item = 0;
+            if (Preload)
+            {
+                for (auto& filename : Items)
+                {
+                    playlist.Add(filename);
+                }
+                playlist.Play();
+            }
+            else
+            {
+                if (!data.LoadFromFile(Items[item], true, false)) return;
+                data.Play();
+            }
+
+            std::vector<double> gaps;
+            std::vector<double> transitiongaps;
+            auto lastpts = std::chrono::microseconds::min();
+            auto lastchange = std::chrono::steady_clock::now();
+            double frametime = 0;
+            auto end = lastchange + std::chrono::seconds(10) * static_cast<int>(Items.size());
+            while (std::chrono::steady_clock::now() < end)
+            {
+                mt::priv::VideoPacket* packet = nullptr;
+                if (Preload)
+                {
+                    playlist.Update();
+                    if (playlist.IsEndofPlaylistReached()) break;
+                    packet = playlist.GetLastPacket();
+                    if (playlist.GetCurrentSource()) frametime = playlist.GetCurrentSource()->GetVideoFrameTime().count() / 1000.0;
+                }
+                else
+                {
+                    data.Update();
+                    if (data.IsEndofFileReached())
+                    {
+                        if (++item == Items.size()) break;
+                        data.LoadFromFile(Items[item], true, false);
+                        data.Play();
+                    }
+                    packet = video.GetLastPacket();
+                    frametime = data.GetVideoFrameTime().count() / 1000.0;
+                }
+                auto now = std::chrono::steady_clock::now();
+                // every item starts over at zero, a timestamp going back marks the switch
+                if (packet && packet->pts != lastpts)
+                {
+                    if (lastpts != std::chrono::microseconds::min())
+                    {
+                        double gap = ToSeconds(now - lastchange) * 1000.0;
+                        gaps.push_back(gap);
+                        if (packet->pts < lastpts) transitiongaps.push_back(gap);
+                    }
+                    lastpts = packet->pts;
+                    lastchange = now;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+
+            std::sort(gaps.begin(), gaps.end());
+            double transitionmax = transitiongaps.empty() ? 0.0 : *std::max_element(transitiongaps.begin(), transitiongaps.end());
+            double transitionaverage = 0;
+            for (double gap : transitiongaps)
+            {
+                transitionaverage += gap / transitiongaps.size();
+            }
+            uint64_t latetransitions = Preload ? playlist.GetLateTransitionCount() : 0;
+            bool passed = true;
+            if (Preload)
+            {
+                // the switch itself may add at most one frame on top of the interval every frame takes
+                passed = Check(!transitiongaps.empty(), "playlist: no transition between items was seen");
+                passed = Check(transitionmax - frametime <= frametime, "playlist: a preloaded switch took " + std::to_string(transitionmax) + "ms with a frame time of " + std::to_string(frametime) + "ms") && passed;
+                passed = Check(latetransitions == 0, "playlist: " + std::to_string(latetransitions) + " late transitions") && passed;
+            }
+            Writer.BeginObject();
+            Writer.Field("mode", Preload ? "playlist" : "reload");
+            Writer.Field("items", Items.size());
+            Writer.Field("transitions", transitiongaps.size());
+            Writer.Field("late_transitions", latetransitions);
+            Writer.Field("frame_time_ms", frametime);
+            Writer.Field("gap_p50_ms", gaps.empty() ? 0.0 : gaps[gaps.size() / 2]);
+            Writer.Field("transition_gap_avg_ms", transitionaverage);
+            Writer.Field("transition_gap_max_ms", transitionmax);
+            Writer.Field("passed", passed);
+            Writer.EndObject();
+        }
+    }
+
+    void RunPlaylistBenchmark(const Options& Options, JsonWriter& Writer)
+    {
+        ClipSpec first("mpeg2_1280x720_gop12_b2_1s", AV_CODEC_ID_MPEG2VIDEO, 1280, 720, 12, 2, 1.0);
+        ClipSpec second("mpeg4_1280x720_gop30_b0_1s", AV_CODEC_ID_MPEG4, 1280, 720, 30, 0, 1.0);
+        std::string firstfile = PrepareClip(Options, first);
+        std::string secondfile = PrepareClip(Options, second);
+        if (firstfile.empty() || secondfile.empty()) return;
+        std::vector<std::string> items;
+        for (int i = 0; i < (Options.quick ? 4 : 8); i++)
+        {
+            items.push_back(i % 2 == 0 ? firstfile : secondfile);
+        }
+        Writer.Key("playlist");
+        Writer.BeginArray();
+        for (bool preload : { false, true })
+        {
+            RunPlaylistSession(items, preload, Writer);
+        }
+        Writer.EndArray();
+    }
+}
@@ -0,0 +1,129 @@
+#include "Scenarios.hpp"
+
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <unistd.h>
+#endif
+
+#define READYFD_SOURCE_COUNT 64
+#define READYFD_PLAYING_EVERY 8
+
+namespace bench
+{
+#ifdef __linux__
+    namespace
+    {
+        /// A compositing host over many sources of which a few play.  Polling checks every source's
+        /// last packet every couple of milliseconds; with ready descriptors one epoll_wait blocks
+        /// until some source has a frame queued or changed state and only those are updated.
+        void RunReadyFdSession(const std::string& Filename, bool Epoll, double Seconds, JsonWriter& Writer)
+        {
+            std::cerr << "readyfd: " << (Epoll ? "epoll on ready descriptors" : "polling") << std::endl;
+            std::vector<std::unique_ptr<mt::DataSource>> sources;
+            std::vector<std::unique_ptr<mt::VideoPlayback>> players;
+            int epollfd = Epoll ? epoll_create1(EPOLL_CLOEXEC) : -1;
+            for (std::size_t i = 0; i < READYFD_SOURCE_COUNT; i++)
+            {
+                sources.push_back(std::make_unique<mt::DataSource>());
+                sources.back()->SetDecodeMode(mt::DecodeMode::SharedScheduler);
+                sources.back()->LoadFromFile(Filename, true, false);
+                players.push_back(std::make_unique<mt::VideoPlayback>(*sources.back()));
+                if (Epoll)
+                {
+                    epoll_event event = {};
+                    event.events = EPOLLIN;
+                    event.data.u64 = i;
+                    epoll_ctl(epollfd, EPOLL_CTL_ADD, players.back()->GetReadyFd(), &event);
+                }
+                if (i % READYFD_PLAYING_EVERY == 0) sources.back()->Play();
+            }
+
+            uint64_t wakeups = 0;
+            uint64_t checks = 0;
+            std::vector<const mt::priv::VideoPacket*> lastpackets(sources.size(), nullptr);
+            uint64_t newframes = 0;
+            double cpustart = GetProcessCpuSeconds();
+            auto start = std::chrono::steady_clock::now();
+            auto end = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(Seconds));
+            auto visit = [&](std::size_t Index)
+            {
+                mt::DataSource& source = *sources[Index];
+                source.Update();
+                if (source.GetState() == mt::State::Stopped && Index % READYFD_PLAYING_EVERY == 0) source.Play();
+                const mt::priv::VideoPacket* packet = players[Index]->GetLastPacket();
+                if (packet != lastpackets[Index]) newframes++;
+                lastpackets[Index] = packet;
+                checks++;
+            };
+            while (std::chrono::steady_clock::now() < end)
+            {
+                wakeups++;
+                if (Epoll)
+                {
+                    // frames are queued ahead of their time, playing sources are visited at least once per frame time
+                    epoll_event events[READYFD_SOURCE_COUNT];
+                    int count = epoll_wait(epollfd, events, READYFD_SOURCE_COUNT, 16);
+                    std::vector<bool> visited(sources.size(), false);
+                    for (int e = 0; e < count; e++)
+                    {
+                        std::size_t index = static_cast<std::size_t>(events[e].data.u64);
+                        players[index]->ClearReady();
+                        visited[index] = true;
+                        visit(index);
+                    }
+                    for (std::size_t i = 0; i < sources.size(); i++)
+                    {
+                        if (!visited[i] && sources[i]->GetState() == mt::State::Playing) visit(i);
+                    }
+                }
+                else
+                {
+                    for (std::size_t i = 0; i < sources.size(); i++)
+                    {
+                        visit(i);
+                    }
+                    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                }
+            }
+            double wallseconds = ToSeconds(std::chrono::steady_clock::now() - start);
+            double cpuseconds = GetProcessCpuSeconds() - cpustart;
+            if (epollfd >= 0) close(epollfd);
+
+            Writer.BeginObject();
+            Writer.Field("mode", Epoll ? "epoll" : "poll");
+            Writer.Field("sources", sources.size());
+            Writer.Field("wakeups_per_second", wallseconds > 0 ? wakeups / wallseconds : 0.0);
+            Writer.Field("source_checks_per_second", wallseconds > 0 ? checks / wallseconds : 0.0);
+            Writer.Field("new_frames", newframes);
+            Writer.Field("cpu_utilisation", wallseconds > 0 ? cpuseconds / wallseconds : 0.0);
+            Writer.EndObject();
+        }
+    }
+#endif
+
+    void RunReadyFdBenchmark(const Options& Options, JsonWriter& Writer)
+    {
+#ifdef __linux__
+        ClipSpec spec("mpeg4_320x240_gop30_b0", AV_CODEC_ID_MPEG4, 320, 240, 30, 0);
+        std::string filename = PrepareClip(Options, spec);
+        if (filename.empty()) return;
+        double seconds = Options.quick ? 2.0 : Options.seconds;
+        Writer.Key("readyfd");
+        Writer.BeginArray();
+        for (bool epoll : { false, true })
+        {
+            RunReadyFdSession(filename, epoll, seconds, Writer);
+        }
+        Writer.EndArray();
+#else
+        // eventfd is Linux only, GetReadyFd() returns -1 everywhere else
+        (void)Options;
+        (void)Writer;
+#endif
+    }
+}
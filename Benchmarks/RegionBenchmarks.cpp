@@ -0,0 +1,58 @@
+#include "Scenarios.hpp"
+
+#include <iostream>
+
+namespace bench
+{
+    namespace
+    {
+        /// Reads every frame with the region of interest set to a centred 1/Divisor of each side
+        /// and reports what conversion and copying cost per frame.
+        void RunRegion(const std::string& Filename, int Divisor, JsonWriter& Writer)
+        {
+            mt::DataSource data;
+            if (!data.LoadFromFile(Filename, true, false)) return;
+            mt::Vector2 size = data.GetVideoSize();
+            int width = size.x / Divisor;
+            int height = size.y / Divisor;
+            data.SetRegionOfInterest(mt::Rect((size.x - width) / 2, (size.y - height) / 2, width, height));
+            std::cerr << "region: " << width << "x" << height << " of " << size.x << "x" << size.y << std::endl;
+            mt::FrameReader reader(data);
+            uint64_t frames = 0;
+            uint64_t mismatched = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (auto& frame : reader)
+            {
+                if (frame->width != width || frame->height != height) mismatched++;
+                frames++;
+            }
+            double seconds = ToSeconds(std::chrono::steady_clock::now() - start);
+            mt::DataSourceStats stats = data.GetStats();
+            Writer.BeginObject();
+            Writer.Field("region_width", width);
+            Writer.Field("region_height", height);
+            Writer.Field("area_fraction", 1.0 / (Divisor * Divisor));
+            Writer.Field("frames", frames);
+            Writer.Field("mismatched_frames", mismatched);
+            Writer.Field("fps", seconds > 0 ? frames / seconds : 0.0);
+            Writer.Field("convert_avg_us", static_cast<long long>(stats.converttime.GetAverage().count()));
+            Writer.Field("copy_avg_us", static_cast<long long>(stats.decodecopytime.GetAverage().count()));
+            Writer.Field("decode_avg_us", static_cast<long long>(stats.decodetime.GetAverage().count()));
+            Writer.EndObject();
+        }
+    }
+
+    void RunRegionBenchmark(const Options& Options, JsonWriter& Writer)
+    {
+        ClipSpec spec("mpeg4_1920x1080_gop30_b0", AV_CODEC_ID_MPEG4, 1920, 1080, 30, 0);
+        std::string filename = PrepareClip(Options, spec);
+        if (filename.empty()) return;
+        Writer.Key("region");
+        Writer.BeginArray();
+        for (int divisor : { 1, 2, 4 })
+        {
+            RunRegion(filename, divisor, Writer);
+        }
+        Writer.EndArray();
+    }
+}
@@ -0,0 +1,98 @@
+#include "Scenarios.hpp"
+
+#include <iostream>
+#include <thread>
+
+namespace bench
+{
+    namespace
+    {
+        /// Steps through Count frames as fast as the decoder delivers them, forward from the start
+        /// or backward from the end, and returns frames per second.
+        double MeasureStepping(const std::string& Filename, bool Reverse, std::size_t CacheLimit, std::size_t Count, mt::DataSourceStats& Stats)
+        {
+            mt::DataSource data;
+            if (!data.LoadFromFile(Filename, true, false)) return 0;
+            mt::VideoPlayback video(data);
+            data.SetReverseCacheLimit(CacheLimit);
+            if (Reverse)
+            {
+                data.SetPlayingOffset(data.GetFileLength());
+                data.SetPlaybackDirection(mt::PlaybackDirection::Reverse);
+            }
+            data.ResetStats();
+            std::size_t stepped = 0;
+            auto start = std::chrono::steady_clock::now();
+            while (stepped < Count && (Reverse ? data.StepBackward() : data.StepForward()))
+            {
+                stepped++;
+            }
+            double seconds = ToSeconds(std::chrono::steady_clock::now() - start);
+            Stats = data.GetStats();
+            return seconds > 0 ? stepped / seconds : 0.0;
+        }
+
+        void RunReverseCase(const std::string& Filename, const char* Name, std::size_t CacheLimit, std::size_t Count, JsonWriter& Writer)
+        {
+            std::cerr << "reverse: " << Name << std::endl;
+            mt::DataSourceStats forwardstats;
+            mt::DataSourceStats reversestats;
+            double forward = MeasureStepping(Filename, false, CacheLimit, Count, forwardstats);
+            double reverse = MeasureStepping(Filename, true, CacheLimit, Count, reversestats);
+            Writer.BeginObject();
+            Writer.Field("case", Name);
+            Writer.Field("cache_limit_bytes", CacheLimit);
+            Writer.Field("frames", Count);
+            Writer.Field("forward_fps", forward);
+            Writer.Field("reverse_fps", reverse);
+            Writer.Field("reverse_to_forward", forward > 0 ? reverse / forward : 0.0);
+            Writer.Field("meets_target", forward > 0 && reverse / forward >= 0.5);
+            Writer.Field("forward_decoded_frames", forwardstats.decodedvideoframes);
+            Writer.Field("reverse_decoded_frames", reversestats.decodedvideoframes);
+            Writer.EndObject();
+        }
+
+        /// Plays backwards in real time and counts frames that were not ready when due.
+        void RunReversePlayback(const std::string& Filename, double Seconds, JsonWriter& Writer)
+        {
+            mt::DataSource data;
+            if (!data.LoadFromFile(Filename, true, false)) return;
+            mt::VideoPlayback video(data);
+            data.SetPlayingOffset(data.GetFileLength());
+            data.SetPlaybackDirection(mt::PlaybackDirection::Reverse);
+            data.ResetStats();
+            data.Play();
+            auto end = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(Seconds));
+            while (std::chrono::steady_clock::now() < end && !data.IsEndofFileReached())
+            {
+                data.Update();
+                std::this_thread::sleep_for(std::chrono::milliseconds(4));
+            }
+            mt::DataSourceStats stats = data.GetStats();
+            Writer.BeginObject();
+            Writer.Field("case", "realtime_reverse");
+            Writer.Field("seconds", Seconds);
+            Writer.Field("presented_frames", stats.presentedframes);
+            Writer.Field("dropped_frames", stats.droppedframes);
+            Writer.Field("deadline_misses", data.GetDeadlineMissCount());
+            Writer.EndObject();
+        }
+    }
+
+    void RunReverseBenchmark(const Options& Options, JsonWriter& Writer)
+    {
+        int seconds = Options.quick ? 4 : 10;
+        ClipSpec spec("mpeg4_640x360_gop30_b2_" + std::to_string(seconds) + "s", AV_CODEC_ID_MPEG4, 640, 360, 30, 2, seconds);
+        std::string filename = PrepareClip(Options, spec);
+        if (filename.empty()) return;
+        std::size_t count = static_cast<std::size_t>(seconds * spec.framerate) - 2;
+        std::size_t framebytes = static_cast<std::size_t>(spec.width) * spec.height * 4;
+        Writer.Key("reverse");
+        Writer.BeginArray();
+        RunReverseCase(filename, "default_cache", 256 * 1024 * 1024, count, Writer);
+        // a cache smaller than a GOP forces several decode passes per GOP
+        RunReverseCase(filename, "cache_smaller_than_gop", framebytes * 24, count, Writer);
+        RunReversePlayback(filename, std::min<double>(seconds - 1, Options.seconds), Writer);
+        Writer.EndArray();
+    }
+}
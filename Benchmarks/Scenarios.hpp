@@ -0,0 +1,31 @@
+#pragma once
+
+#include "BenchUtil.hpp"
+#include "JsonWriter.hpp"
+
+namespace bench
+{
+    /// Every scenario writes one keyed value into the top level "scenarios" object.
+    void RunDecodeBenchmarks(const Options& Options, JsonWriter& Writer);
+    void RunMemoryBenchmark(const Options& Options, JsonWriter& Writer);
+    void RunSchedulerStress(const Options& Options, JsonWriter& Writer);
+    void RunAudioBenchmark(const Options& Options, JsonWriter& Writer);
+    void RunDriftBenchmark(const Options& Options, JsonWriter& Writer);
+    void RunSpeedBenchmark(const Options& Options, JsonWriter& Writer);
+    void RunReverseBenchmark(const Options& Options, JsonWriter& Writer);
+    void RunScrubBenchmark(const Options& Options, JsonWriter& Writer);
+    void RunOfflineBenchmark(const Options& Options, JsonWriter& Writer);
+    void RunAsyncBenchmark(const Options& Options, JsonWriter& Writer);
+    void RunGovernorBenchmark(const Options& Options, JsonWriter& Writer);
+    void RunTrackBenchmark(const Options& Options, JsonWriter& Writer);
+    void RunBackpressureBenchmark(const Options& Options, JsonWriter& Writer);
+    void RunFilterBenchmark(const Options& Options, JsonWriter& Writer);
+    void RunRegionBenchmark(const Options& Options, JsonWriter& Writer);
+    void RunLoopBenchmark(const Options& Options, JsonWriter& Writer);
+    void RunPlaylistBenchmark(const Options& Options, JsonWriter& Writer);
+    void RunSinkBenchmark(const Options& Options, JsonWriter& Writer);
+    void RunAlignmentBenchmark(const Options& Options, JsonWriter& Writer);
+    void RunCallbackBenchmark(const Options& Options, JsonWriter& Writer);
+    void RunReadyFdBenchmark(const Options& Options, JsonWriter& Writer);
+    void RunAttachBenchmark(const Options& Options, JsonWriter& Writer);
+}
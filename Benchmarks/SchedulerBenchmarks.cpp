@@ -0,0 +1,93 @@
+#include "Scenarios.hpp"
+
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace bench
+{
+    namespace
+    {
+        /// Plays Count looping copies of the clip for the given time, rendering at ~60Hz like a UI would.
+        /// Every tenth source is a high priority "hero", the rest run at low priority.
+        void RunLoopingSources(const Options& Options, const std::string& Filename, mt::DecodeMode Mode, const char* Name, JsonWriter& Writer)
+        {
+            std::cerr << "scheduler: " << Options.sources << " sources, " << Name << std::endl;
+            std::vector<std::unique_ptr<mt::DataSource>> sources;
+            std::vector<std::unique_ptr<mt::VideoPlayback>> players;
+            for (std::size_t i = 0; i < Options.sources; i++)
+            {
+                sources.push_back(std::make_unique<mt::DataSource>());
+                sources.back()->SetDecodeMode(Mode);
+                sources.back()->SetPriority(i % 10 == 0 ? mt::DecodePriority::High : mt::DecodePriority::Low);
+                sources.back()->LoadFromFile(Filename, true, false);
+                players.push_back(std::make_unique<mt::VideoPlayback>(*sources.back()));
+                sources.back()->Play();
+            }
+            for (auto& source : sources)
+            {
+                source->ResetStats();
+            }
+
+            int maxthreads = 0;
+            double cpustart = GetProcessCpuSeconds();
+            auto wallstart = std::chrono::steady_clock::now();
+            auto wallend = wallstart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(Options.seconds));
+            auto nextframe = wallstart;
+            while (std::chrono::steady_clock::now() < wallend)
+            {
+                for (auto& source : sources)
+                {
+                    source->Update();
+                    // reaching the end stops and rewinds the source, start it again to loop
+                    if (source->GetState() == mt::State::Stopped) source->Play();
+                }
+                maxthreads = std::max(maxthreads, GetThreadCount());
+                nextframe += std::chrono::microseconds(16667);
+                std::this_thread::sleep_until(nextframe);
+            }
+            double wallseconds = ToSeconds(std::chrono::steady_clock::now() - wallstart);
+            double cpuseconds = GetProcessCpuSeconds() - cpustart;
+
+            uint64_t presented[2] = { 0, 0 };
+            uint64_t misses[2] = { 0, 0 };
+            uint64_t counts[2] = { 0, 0 };
+            for (auto& source : sources)
+            {
+                mt::DataSourceStats stats = source->GetStats();
+                int index = source->GetPriority() == mt::DecodePriority::High ? 1 : 0;
+                presented[index] += stats.presentedframes;
+                misses[index] += stats.deadlinemisses;
+                counts[index]++;
+            }
+
+            Writer.Key(Name);
+            Writer.BeginObject();
+            Writer.Field("sources", Options.sources);
+            Writer.Field("max_threads", maxthreads);
+            Writer.Field("wall_seconds", wallseconds);
+            Writer.Field("cpu_seconds", cpuseconds);
+            Writer.Field("cpu_utilisation", wallseconds > 0 ? cpuseconds / wallseconds : 0.0);
+            Writer.Field("presented_frames", presented[0] + presented[1]);
+            Writer.Field("deadline_misses", misses[0] + misses[1]);
+            Writer.Field("high_priority_deadline_misses_per_source", counts[1] ? static_cast<double>(misses[1]) / counts[1] : 0.0);
+            Writer.Field("low_priority_deadline_misses_per_source", counts[0] ? static_cast<double>(misses[0]) / counts[0] : 0.0);
+            Writer.EndObject();
+        }
+    }
+
+    void RunSchedulerStress(const Options& Options, JsonWriter& Writer)
+    {
+        ClipSpec spec("mpeg4_160x90_gop30_b0", AV_CODEC_ID_MPEG4, 160, 90, 30, 0);
+        std::string filename = PrepareClip(Options, spec);
+        if (filename.empty()) return;
+        Writer.Key("scheduler");
+        Writer.BeginObject();
+        Writer.Field("clip", spec.name);
+        Writer.Field("worker_count", mt::DecodeScheduler::GetInstance().GetWorkerCount());
+        RunLoopingSources(Options, filename, mt::DecodeMode::DedicatedThread, "dedicated_threads", Writer);
+        RunLoopingSources(Options, filename, mt::DecodeMode::SharedScheduler, "shared_scheduler", Writer);
+        Writer.EndObject();
+    }
+}
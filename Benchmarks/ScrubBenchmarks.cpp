@@ -0,0 +1,74 @@
+#include "Scenarios.hpp"
+
+#include <iostream>
+#include <random>
+
+namespace bench
+{
+    namespace
+    {
+        /// Editor style scrubbing: step over the same stretch of frames back and forth, then jump
+        /// around inside it with SetPlayingOffset, once without and once with the frame cache.
+        void RunScrub(const std::string& Filename, std::size_t CacheLimit, int Frames, int Rounds, JsonWriter& Writer)
+        {
+            mt::DataSource data;
+            if (!data.LoadFromFile(Filename, true, false)) return;
+            mt::VideoPlayback video(data);
+            data.SetFrameCacheLimit(CacheLimit);
+            std::cerr << "scrub: cache " << CacheLimit << " bytes" << std::endl;
+            for (int i = 0; i < Frames && data.StepForward(); i++) { }
+            data.ResetStats();
+
+            int steps = 0;
+            auto stepstart = std::chrono::steady_clock::now();
+            for (int round = 0; round < Rounds; round++)
+            {
+                for (int i = 0; i < Frames / 2 && data.StepBackward(); i++) steps++;
+                for (int i = 0; i < Frames / 2 && data.StepForward(); i++) steps++;
+            }
+            double stepseconds = ToSeconds(std::chrono::steady_clock::now() - stepstart);
+            mt::DataSourceStats stepstats = data.GetStats();
+            data.ResetStats();
+
+            std::mt19937 random(42);
+            std::uniform_int_distribution<long long> position(0, static_cast<long long>(Frames) * data.GetVideoFrameTime().count());
+            const int seeks = 200;
+            auto seekstart = std::chrono::steady_clock::now();
+            for (int i = 0; i < seeks; i++)
+            {
+                data.SetPlayingOffset(std::chrono::microseconds(position(random)));
+            }
+            double seekseconds = ToSeconds(std::chrono::steady_clock::now() - seekstart);
+            mt::DataSourceStats seekstats = data.GetStats();
+
+            Writer.BeginObject();
+            Writer.Field("cache_limit_bytes", CacheLimit);
+            Writer.Field("steps", steps);
+            Writer.Field("steps_per_second", stepseconds > 0 ? steps / stepseconds : 0.0);
+            Writer.Field("step_decoded_frames", stepstats.decodedvideoframes);
+            Writer.Field("step_cache_hits", stepstats.framecachehits);
+            Writer.Field("step_cache_misses", stepstats.framecachemisses);
+            Writer.Field("seeks", seeks);
+            Writer.Field("seek_average_us", seekseconds * 1000000.0 / seeks);
+            Writer.Field("seek_cache_hit_rate", seekstats.framecachehits + seekstats.framecachemisses > 0 ? static_cast<double>(seekstats.framecachehits) / (seekstats.framecachehits + seekstats.framecachemisses) : 0.0);
+            Writer.Field("cache_bytes", seekstats.framecachebytes);
+            Writer.EndObject();
+        }
+    }
+
+    void RunScrubBenchmark(const Options& Options, JsonWriter& Writer)
+    {
+        ClipSpec spec("mpeg4_640x360_gop60_b2_6s", AV_CODEC_ID_MPEG4, 640, 360, 60, 2, 6);
+        std::string filename = PrepareClip(Options, spec);
+        if (filename.empty()) return;
+        int frames = Options.quick ? 60 : 120;
+        int rounds = Options.quick ? 2 : 4;
+        Writer.Key("scrub");
+        Writer.BeginArray();
+        for (std::size_t limit : { static_cast<std::size_t>(0), static_cast<std::size_t>(256 * 1024 * 1024) })
+        {
+            RunScrub(filename, limit, frames, rounds, Writer);
+        }
+        Writer.EndArray();
+    }
+}
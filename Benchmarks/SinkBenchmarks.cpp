@@ -0,0 +1,121 @@
+#include "Scenarios.hpp"
+
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+#define SINK_BUFFER_COUNT 16
+
+namespace bench
+{
+    namespace
+    {
+        /// Stands in for a ring of persistently mapped upload buffers.
+        class PoolSink : public mt::FrameSink
+        {
+        private:
+            std::mutex m_lock;
+            std::vector<std::vector<uint8_t>> m_buffers;
+            std::vector<uint8_t*> m_free;
+            uint64_t m_exhausted;
+
+        public:
+            PoolSink(int Width, int Height) :
+                m_lock(),
+                m_buffers(SINK_BUFFER_COUNT, std::vector<uint8_t>(static_cast<std::size_t>(Width) * Height * 4)),
+                m_free(),
+                m_exhausted(0)
+            {
+                for (auto& buffer : m_buffers)
+                {
+                    m_free.push_back(buffer.data());
+                }
+            }
+
+            uint8_t* AcquireBuffer(int Width, int Height, int& Stride) override
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                if (m_free.empty() || Stride < Width * 4 || static_cast<std::size_t>(Stride) * Height > m_buffers[0].size())
+                {
+                    m_exhausted++;
+                    return nullptr;
+                }
+                uint8_t* buffer = m_free.back();
+                m_free.pop_back();
+                return buffer;
+            }
+
+            void ReleaseBuffer(uint8_t* Buffer) override
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                m_free.push_back(Buffer);
+            }
+
+            uint64_t GetExhaustedCount()
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                return m_exhausted;
+            }
+        };
+
+        /// Reads every frame and gets it into "upload memory", either by copying each packet into
+        /// it the way an application has to without a sink or by having the scaler write there.
+        void RunSink(const std::string& Filename, bool Sink, JsonWriter& Writer)
+        {
+            mt::DataSource data;
+            if (!data.LoadFromFile(Filename, true, false)) return;
+            mt::Vector2 size = data.GetVideoSize();
+            std::shared_ptr<PoolSink> sink;
+            if (Sink)
+            {
+                sink = std::make_shared<PoolSink>(size.x, size.y);
+                data.SetFrameSink(sink);
+            }
+            std::cerr << "sink: " << (Sink ? "frame sink" : "copy into upload buffer") << std::endl;
+            std::vector<uint8_t> upload(static_cast<std::size_t>(size.x) * size.y * 4);
+            mt::FrameReader reader(data);
+            uint64_t frames = 0;
+            double cpustart = GetProcessCpuSeconds();
+            auto start = std::chrono::steady_clock::now();
+            std::chrono::steady_clock::duration uploadtime(0);
+            for (auto& frame : reader)
+            {
+                if (!Sink)
+                {
+                    auto copystart = std::chrono::steady_clock::now();
+                    std::memcpy(upload.data(), frame->GetRGBABuffer(), static_cast<std::size_t>(frame->stride) * frame->height);
+                    uploadtime += std::chrono::steady_clock::now() - copystart;
+                }
+                frames++;
+            }
+            double seconds = ToSeconds(std::chrono::steady_clock::now() - start);
+            double cpuseconds = GetProcessCpuSeconds() - cpustart;
+            mt::DataSourceStats stats = data.GetStats();
+            Writer.BeginObject();
+            Writer.Field("mode", Sink ? "sink" : "copy");
+            Writer.Field("frames", frames);
+            Writer.Field("wall_seconds", seconds);
+            Writer.Field("cpu_seconds", cpuseconds);
+            Writer.Field("fps", seconds > 0 ? frames / seconds : 0.0);
+            Writer.Field("convert_avg_us", static_cast<long long>(stats.converttime.GetAverage().count()));
+            Writer.Field("upload_copy_avg_us", frames > 0 ? ToSeconds(uploadtime) * 1000000.0 / frames : 0.0);
+            Writer.Field("sink_exhausted", sink ? sink->GetExhaustedCount() : static_cast<uint64_t>(0));
+            Writer.EndObject();
+        }
+    }
+
+    void RunSinkBenchmark(const Options& Options, JsonWriter& Writer)
+    {
+        ClipSpec spec("mpeg4_1920x1080_gop30_b0", AV_CODEC_ID_MPEG4, 1920, 1080, 30, 0);
+        std::string filename = PrepareClip(Options, spec);
+        if (filename.empty()) return;
+        Writer.Key("sink");
+        Writer.BeginArray();
+        for (bool sink : { false, true })
+        {
+            RunSink(filename, sink, Writer);
+        }
+        Writer.EndArray();
+    }
+}
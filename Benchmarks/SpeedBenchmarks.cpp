@@ -0,0 +1,70 @@
+#include "Scenarios.hpp"
+
+#include <iostream>
+#include <thread>
+
+namespace bench
+{
+    namespace
+    {
+        /// Plays the clip with audio at one speed for a fixed wall time, a simulated device drains
+        /// the stretched audio in real time.  CPU is reported per second of media covered so the
+        /// cost of the higher speeds can be compared against 1x directly.
+        void RunSpeed(const std::string& Filename, float Speed, double Seconds, JsonWriter& Writer)
+        {
+            mt::DataSource data;
+            if (!data.LoadFromFile(Filename)) return;
+            mt::VideoPlayback video(data);
+            mt::AudioPlayback audio(data);
+            data.SetPlaybackSpeed(Speed);
+            std::cerr << "speed: " << Speed << "x" << std::endl;
+
+            SimulatedDevice device(audio, 512);
+
+            data.Play();
+            double cpustart = GetProcessCpuSeconds();
+            auto wallstart = std::chrono::steady_clock::now();
+            auto wallend = wallstart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(Seconds));
+            while (std::chrono::steady_clock::now() < wallend && !data.IsEndofFileReached())
+            {
+                data.Update();
+                std::this_thread::sleep_for(std::chrono::milliseconds(16));
+            }
+            double mediaseconds = data.GetPlayingOffset().count() / 1000000.0;
+            double wallseconds = ToSeconds(std::chrono::steady_clock::now() - wallstart);
+            double cpuseconds = GetProcessCpuSeconds() - cpustart;
+            device.Stop();
+
+            mt::DataSourceStats stats = data.GetStats();
+            Writer.BeginObject();
+            Writer.Field("speed", static_cast<double>(Speed));
+            Writer.Field("wall_seconds", wallseconds);
+            Writer.Field("media_seconds", mediaseconds);
+            Writer.Field("cpu_seconds", cpuseconds);
+            Writer.Field("cpu_per_media_second", mediaseconds > 0 ? cpuseconds / mediaseconds : 0.0);
+            Writer.Field("cpu_per_wall_second", wallseconds > 0 ? cpuseconds / wallseconds : 0.0);
+            Writer.Field("decoded_video_frames", stats.decodedvideoframes);
+            Writer.Field("presented_frames", stats.presentedframes);
+            Writer.Field("dropped_frames", stats.droppedframes);
+            Writer.Field("audio_underruns", audio.GetUnderrunCount());
+            Writer.EndObject();
+        }
+    }
+
+    void RunSpeedBenchmark(const Options& Options, JsonWriter& Writer)
+    {
+        // the clip has to outlast the fastest run
+        double seconds = Options.quick ? 1.0 : 3.0;
+        int cliplength = static_cast<int>(seconds * 16) + 2;
+        ClipSpec spec("mpeg4_640x360_gop30_b2_" + std::to_string(cliplength) + "s", AV_CODEC_ID_MPEG4, 640, 360, 30, 2, cliplength, true);
+        std::string filename = PrepareClip(Options, spec);
+        if (filename.empty()) return;
+        Writer.Key("speed");
+        Writer.BeginArray();
+        for (float speed : { 0.25f, 0.5f, 1.f, 2.f, 4.f, 8.f, 16.f })
+        {
+            RunSpeed(filename, speed, seconds, Writer);
+        }
+        Writer.EndArray();
+    }
+}
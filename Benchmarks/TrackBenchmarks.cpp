@@ -0,0 +1,62 @@
+#include "Scenarios.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace bench
+{
+    namespace
+    {
+        /// Plays the file to the end with a device that drains audio as fast as it can and
+        /// reports how much of the file the demuxer had to read.
+        void RunPlayback(const std::string& Filename, const std::string& Container, bool EnableVideo, JsonWriter& Writer)
+        {
+            mt::DataSource data;
+            if (!data.LoadFromFile(Filename, EnableVideo, true)) return;
+            std::cerr << "tracks: " << Container << (EnableVideo ? " audio and video" : " audio only") << std::endl;
+            mt::AudioPlayback audio(data);
+            std::unique_ptr<mt::VideoPlayback> video(EnableVideo ? new mt::VideoPlayback(data) : nullptr);
+            data.SetMasterClock(&audio);
+            std::vector<int16_t> period(4096 * std::max(audio.GetChannelCount(), 1));
+            uint64_t readstart = GetProcessReadBytes();
+            data.Play();
+            PumpUntil(data, [&]()
+            {
+                audio.ReadSamples(period.data(), 4096);
+                return data.IsEndofFileReached();
+            }, std::chrono::seconds(60));
+            uint64_t processread = GetProcessReadBytes() - readstart;
+            mt::DataSourceStats stats = data.GetStats();
+
+            Writer.BeginObject();
+            Writer.Field("container", Container);
+            Writer.Field("video_enabled", EnableVideo);
+            Writer.Field("streams", data.GetStreams().size());
+            Writer.Field("demuxer_bytes_read", stats.bytesread);
+            Writer.Field("process_bytes_read", processread);
+            Writer.Field("decoded_video_frames", stats.decodedvideoframes);
+            Writer.Field("decoded_audio_frames", stats.decodedaudioframes);
+            Writer.EndObject();
+        }
+    }
+
+    void RunTrackBenchmark(const Options& Options, JsonWriter& Writer)
+    {
+        int seconds = Options.quick ? 3 : 8;
+        Writer.Key("tracks");
+        Writer.BeginArray();
+        // matroska reads whole clusters, mp4 seeks straight to the samples of the selected streams
+        for (const char* container : { "matroska", "mp4" })
+        {
+            ClipSpec spec("mpeg4_1280x720_gop30_b2_" + std::to_string(seconds) + "s", AV_CODEC_ID_MPEG4, 1280, 720, 30, 2, seconds, true);
+            spec.container = container;
+            std::string filename = PrepareClip(Options, spec);
+            if (filename.empty()) continue;
+            RunPlayback(filename, container, true, Writer);
+            RunPlayback(filename, container, false, Writer);
+        }
+        Writer.EndArray();
+    }
+}
@@ -1,15 +1,17 @@
 #pragma once
 
 #include <memory>
-#include <queue>
 #include <thread>
 #include <chrono>
 #include <cmath>
 #include <vector>
 #include <cstdint>
+#include <atomic>
+#include <deque>
+#include <mutex>
 
 #include "include/DataSource.hpp"
-#include "include/priv/AudioPacket.hpp"
+#include "include/priv/AudioConsumer.hpp"
 #include "include/State.hpp"
 #include "include/NonCopyable.h"
 
@@ -17,31 +19,35 @@ namespace mt
 {
     class DataSource;
 
+    /// Pull model audio output.  The decode thread fills a lock free ring of interleaved signed
+    /// 16 bit PCM and the audio device callback drains it through ReadSamples, which never
+    /// blocks or allocates.  Running dry is counted as an underrun and padded with silence.
     class AudioPlayback : private mt::NonCopyable
     {
         friend class DataSource;
 
     private:
-		std::chrono::microseconds m_audiorate;
-        int m_channelcount;
-		std::chrono::microseconds m_audioposition;
-		std::chrono::microseconds m_offsetcorrection;
-		std::chrono::steady_clock::time_point mStart;
-        DataSource* m_datasource;
-        std::mutex m_protectionlock;
-        std::queue<priv::AudioPacketPtr> m_queuedaudiopackets;
-        priv::AudioPacketPtr m_activepacket;
+        priv::AudioConsumerPtr m_consumer;
 
-        void onSeek(std::chrono::microseconds timeOffset);
-        bool WaitForData();
-        void SourceReloaded();
-        void StateChanged(State PreviousState, State NewState);
     public:
-        AudioPlayback(DataSource& DataSource, std::chrono::microseconds OffsetCorrection = std::chrono::milliseconds(300));
+        AudioPlayback(DataSource& DataSource, std::chrono::microseconds OffsetCorrection = std::chrono::microseconds(0));
         ~AudioPlayback();
+        /// Real time safe.  Copies up to FrameCount frames (GetChannelCount() samples each) and
+        /// fills the rest of the destination with silence, returns the number of decoded frames copied.
+        std::size_t ReadSamples(int16_t* Destination, std::size_t FrameCount);
+        const int GetChannelCount();
+        const int GetSampleRate();
+        const std::size_t GetBufferedFrameCount();
+        const uint64_t GetConsumedFrameCount();
+        const uint64_t GetUnderrunCount();
+        /// True once samples written since the last seek carry a timestamp.
+        const bool HasClock();
+        /// Timestamp of the sample the device is playing, the offset correction subtracted.
+        const std::chrono::microseconds GetClock();
         const float GetVolume();
         void SetVolume(float Volume);
+        /// Output latency of the audio device, how far behind ReadSamples the speaker is.
         const std::chrono::microseconds GetOffsetCorrection();
         void SetOffsetCorrection(std::chrono::microseconds OffsetCorrection);
     };
-}
\ No newline at end of file
+}
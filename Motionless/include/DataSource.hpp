@@ -7,13 +7,30 @@
 #include <chrono>
 #include <atomic>
 #include <queue>
+#include <deque>
 #include <vector>
 #include <iostream>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <functional>
 
-#include "include/priv/AudioPacket.hpp"
 #include "include/AudioPlayback.hpp"
+#include "include/DecodeScheduler.hpp"
+#include "include/Executor.hpp"
+#include "include/FrameSink.hpp"
+#include "include/MemoryGovernor.hpp"
+#include "include/PlaybackDirection.hpp"
+#include "include/PlaybackStats.hpp"
+#include "include/QueueLimits.hpp"
+#include "include/StreamInfo.hpp"
+#include "include/priv/AudioConsumer.hpp"
+#include "include/priv/AudioTempo.hpp"
+#include "include/priv/FrameCache.hpp"
+#include "include/priv/ReadyNotifier.hpp"
+#include "include/priv/StatsCollector.hpp"
+#include "include/priv/VideoConsumer.hpp"
+#include "include/priv/VideoFilter.hpp"
 #include "include/priv/VideoPacket.hpp"
 #include "include/VideoPlayback.hpp"
 #include "include/State.hpp"
@@ -26,12 +43,21 @@ extern "C"
 #include <libswscale/swscale.h>
 #include <libswresample/swresample.h>
 #include <libavutil/opt.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
 }
 
 namespace mt
 {
     class VideoPlayback;
     class AudioPlayback;
+    class Playlist;
+
+    namespace priv
+    {
+        class VideoConsumer;
+        class AudioConsumer;
+    }
 
 	class Vector2
 	{
@@ -44,15 +70,55 @@ namespace mt
 		}
 	};
 
+	/// Region of the frame in pixels, an empty one stands for the whole frame.
+	class Rect
+	{
+	public:
+		int left, top, width, height;
+		Rect(int Left = 0, int Top = 0, int Width = 0, int Height = 0)
+		{
+			left = Left;
+			top = Top;
+			width = Width;
+			height = Height;
+		}
+	};
+
     class DataSource : private mt::NonCopyable
     {
         friend class VideoPlayback;
         friend class AudioPlayback;
+        friend class DecodeScheduler;
+        friend class FrameReader;
+        friend class Playlist;
+        friend class priv::VideoConsumer;
+        friend class priv::AudioConsumer;
 
     public:
-		
+        typedef std::function<void(DataSource& Source, std::chrono::microseconds Pts)> FrameReadyCallback;
+        typedef std::function<void(DataSource& Source, State PreviousState, State NewState)> StateChangedCallback;
 
     private:
+        /// The consumers attached to the source.  A list is never changed once it is published,
+        /// the render and decode threads load the current one and walk it without a lock while
+        /// attaching or detaching publishes a changed copy under m_playbacklock.  A detached
+        /// consumer lives on until the last list holding it is let go.
+        class PlaybackList
+        {
+        public:
+            std::vector<priv::VideoConsumerPtr> video;
+            std::vector<priv::AudioConsumerPtr> audio;
+            priv::AudioConsumerPtr masterclock;
+
+            PlaybackList() :
+                video(),
+                audio(),
+                masterclock(nullptr)
+            { }
+        };
+        typedef std::shared_ptr<const PlaybackList> PlaybackListPtr;
+
+        std::string m_filename;
         int m_videostreamid;
         int m_audiostreamid;
 		std::chrono::steady_clock::time_point m_start;
@@ -60,37 +126,156 @@ namespace mt
 		std::chrono::microseconds m_filelength;
         Vector2 m_videosize;
         int m_audiochannelcount;
-        float m_playbackspeed;
+        std::atomic<float> m_playbackspeed;
         AVFormatContext* m_formatcontext;
         AVCodecContext* m_videocontext;
         AVCodecContext* m_audiocontext;
         AVCodec* m_videocodec;
         AVCodec* m_audiocodec;
         AVFrame* m_videorawframe;
-        AVFrame* m_videorgbaframe;
         AVFrame* m_audiorawbuffer;
         uint8_t* m_videorawbuffer;
-        uint8_t* m_videorgbabuffer;
+        std::size_t m_videorawbuffersize;
         uint8_t* m_audiopcmbuffer;
         SwsContext* m_videoswcontext;
+        std::mutex m_regionlock;
+        Rect m_region;
+        Rect m_convertregion;
+        std::mutex m_sinklock;
+        FrameSinkPtr m_framesink;
+        std::atomic<int> m_rowalignment;
         SwrContext* m_audioswcontext;
         State m_state;
+        DecodeMode m_decodemode;
         std::unique_ptr<std::thread> m_decodethread;
         std::atomic<bool> m_shouldthreadrun;
+        std::atomic<int> m_taskstate;
+        std::atomic<DecodePriority> m_priority;
+        std::atomic<long long> m_nextdeadline;
+        std::atomic<unsigned int> m_schedulerpasses;
+        std::atomic<unsigned int> m_deadlinemisscount;
+        priv::StatsCollector m_stats;
+        int64_t m_lastreadposition;
+        std::chrono::steady_clock::time_point m_seekstart;
+        std::atomic<bool> m_seekpending;
+        bool m_audiosynced;
+        std::chrono::microseconds m_audioanchorpts;
+        int64_t m_audiosamplecount;
+        std::chrono::microseconds m_nextvideopts;
+        priv::AudioTempo m_audiotempo;
+        std::string m_videofilterdescription;
+        priv::VideoFilter m_videofilter;
+        std::atomic<PlaybackDirection> m_direction;
+        std::atomic<std::size_t> m_reversecachelimit;
+        std::deque<priv::VideoPacketPtr> m_reverseframes;
+        std::chrono::microseconds m_reverseupper;
+        bool m_reversedone;
+        priv::FrameCache m_framecache;
+        std::atomic<bool> m_looping;
+        std::atomic<long long> m_loopstart;
+        std::atomic<long long> m_loopend;
+        std::atomic<long long> m_looplength;
+        std::chrono::microseconds m_loopshift;
+        std::chrono::microseconds m_loopresume;
+        std::chrono::microseconds m_loopskipuntil;
+        std::deque<priv::VideoPacketPtr> m_loopprefetch;
+        std::size_t m_loopfeed;
+        std::atomic<std::size_t> m_looppending;
+        bool m_loopcapturing;
+        bool m_loopprefetchpending;
+        bool m_loopwrap;
+        std::chrono::microseconds m_nextaudiopts;
+        bool m_seekdeferred;
+        std::atomic<int> m_offlinereaders;
+        std::mutex m_wakelock;
+        std::condition_variable m_wakecondition;
+        bool m_wakepending;
+        std::mutex m_limitslock;
+        QueueLimits m_queuelimits;
+        double m_producemean;
+        double m_producevariance;
+        std::atomic<long long> m_queuetarget;
+        std::atomic<std::size_t> m_videoqueuedepth;
+        std::atomic<std::size_t> m_audioqueueframes;
+        std::deque<AVPacket*> m_parkedvideo;
+        std::deque<AVPacket*> m_parkedaudio;
+        std::atomic<std::size_t> m_parkedcount;
+        std::atomic<std::size_t> m_parkedbytes;
+        std::atomic<bool> m_demuxeof;
+        priv::MemoryAccountPtr m_memory;
         std::atomic<bool> m_eofreached;
         std::atomic<bool> m_playingtoeof;
+        std::size_t m_slicevideoframes;
         std::mutex m_playbacklock;
-        std::vector<mt::VideoPlayback*> m_videoplaybacks;
-        std::vector<mt::AudioPlayback*> m_audioplaybacks;
+        PlaybackListPtr m_playbacks;
+        std::mutex m_callbacklock;
+        FrameReadyCallback m_framereadycallback;
+        Executor m_framereadyexecutor;
+        StateChangedCallback m_statechangedcallback;
+        Executor m_statechangedexecutor;
+        priv::ReadyNotifier m_ready;
 
-        AVFrame* CreatePictureFrame(AVPixelFormat SelectedPixelFormat, int Width, int Height, unsigned char*& PictureBuffer);
-        void DestroyPictureFrame(AVFrame*& PictureFrame, unsigned char*& PictureBuffer);
+        AVFrame* CreatePictureFrame(AVPixelFormat SelectedPixelFormat, int Width, int Height, unsigned char*& PictureBuffer, std::size_t& PictureBufferSize);
+        void DestroyPictureFrame(AVFrame*& PictureFrame, unsigned char*& PictureBuffer, std::size_t& PictureBufferSize);
         void Cleanup();
+        bool Load(const std::string& Filename, int VideoStream, int AudioStream);
         void StartDecodeThread();
         void StopDecodeThread();
         void DecodeThreadRun();
+        bool DecodeSlice(std::size_t FrameLimit);
+        bool DecodeReverseSlice();
+        void DecodeReverseSegment();
+        void FeedReverseFrames();
+        bool StepFrame(PlaybackDirection Direction);
+        std::chrono::microseconds GetStepOrigin(PlaybackDirection Direction);
+        bool HasQueuedStep(bool Reverse);
+        bool StepCachedFrame(bool Reverse);
+        bool PresentCachedFrame(std::chrono::microseconds PlayingOffset);
+        void Seek(std::chrono::microseconds PlayingOffset);
+        void SeekDemuxer(std::chrono::microseconds PlayingOffset);
+        void SeekLoopStart();
+        void PrefetchLoop();
+        bool WrapLoop();
+        bool FeedLoopFrame();
+        bool IsOutsideLoop(std::chrono::microseconds Pts);
+        std::chrono::microseconds MapLoopOffset(std::chrono::microseconds Offset);
+        void ResetLoop(std::chrono::microseconds PlayingOffset);
+        void SetLoopRange(std::chrono::microseconds Start, std::chrono::microseconds End, bool Looping);
+        void RequestDecode();
+        void WakeReaders();
         bool IsFull();
+        bool HasRoom(const PlaybackList& Playbacks, int StreamId);
+        bool HasConsumers(const PlaybackList& Playbacks, int StreamId);
+        AVPacket* ReadPacket();
+        bool DecodePacket(AVPacket* Packet);
+        void ParkPacket(AVPacket* Packet);
+        AVPacket* TakeParkedPacket();
+        void FlushParkedPackets();
+        void RecordProduceTime(std::chrono::steady_clock::duration Duration);
+        void UpdateQueueDepth();
+        bool IsBehind();
+        void UpdateDeadline(const PlaybackList& Playbacks);
+        void RecordBytesRead();
+        void RecordSeekLatency();
+        std::chrono::microseconds StreamTimeToOffset(int StreamId, int64_t Timestamp);
+        std::chrono::microseconds SyncAudioTimestamp(int64_t Timestamp, int SampleCount);
+        bool DecodeVideoPacket(AVPacket* Packet);
+        bool CreateVideoFilter();
+        Rect ClampRegion(int Width, int Height, int AlignX, int AlignY);
+        const Vector2 GetOutputSize();
+        const std::size_t GetFrameBytes();
+        bool ConvertVideoFrame(const std::function<void(const priv::VideoPacketPtr& Packet)>& Output);
+        void PushVideoPacket(const priv::VideoPacketPtr& Packet);
+        void PushAudio(const int16_t* Samples, int FrameCount, std::chrono::microseconds Pts, float Tempo);
+        const PlaybackListPtr GetPlaybacks();
+        void PublishPlaybacks(std::unique_ptr<PlaybackList> Playbacks);
+        void AttachPlayback(const priv::VideoConsumerPtr& Consumer);
+        void AttachPlayback(const priv::AudioConsumerPtr& Consumer);
+        void DetachPlayback(const priv::VideoConsumerPtr& Consumer);
+        void DetachPlayback(const priv::AudioConsumerPtr& Consumer);
         void NotifyStateChanged(State NewState);
+        void SetState(State NewState);
+        void NotifyFrameReady(std::chrono::microseconds Pts);
 
     public:
 		typedef enum
@@ -103,12 +288,40 @@ namespace mt
         DataSource();
         ~DataSource();
         bool LoadFromFile(const std::string& Filename, bool EnableVideo = true, bool EnableAudio = true);
+        /// Every stream in the loaded file, selected or not.
+        const std::vector<StreamInfo> GetStreams();
+        const int GetVideoStream();
+        const int GetAudioStream();
+        /// Reopens the file decoding the given streams, -1 leaves that kind out, and picks up at
+        /// the same position and state.  This is a full reload, queued frames and samples are
+        /// dropped.  An invalid selection returns false and leaves the current streams playing.  Streams that are not selected are discarded by the demuxer.  Only one video
+        /// stream is decoded per source; several video tracks at once are not supported, opening
+        /// one source per track works but demuxes the file once for every track.
+        bool SelectStreams(int VideoStream, int AudioStream);
         void Play();
         void Pause();
         void Stop();
         const bool HasVideo();
         const bool HasAudio();
+        /// Size of the frames handed out, the region of interest when one is set.
         const Vector2 GetVideoSize();
+        const Rect GetRegionOfInterest();
+        /// Only this part of the frame is converted and stored, so conversion and copy cost follow
+        /// the visible area.  Clamped to the frame, an empty rectangle goes back to the whole of
+        /// it.  Takes effect with the next converted frame.  With a video filter the region is cut
+        /// from the graph's output, put a crop in the graph to save its conversion too.
+        void SetRegionOfInterest(const Rect& Region);
+        const FrameSinkPtr GetFrameSink();
+        /// Frames are converted straight into memory from Sink, see FrameSink.  Takes effect with
+        /// the next converted frame, nullptr goes back to the library's own memory.  With a video
+        /// filter the graph's output is copied into it once.
+        void SetFrameSink(FrameSinkPtr Sink);
+        const int GetRowAlignment();
+        /// Rows of converted frames start at multiples of Bytes, a power of two up to 4096, so SIMD
+        /// post processing and driver upload fast paths see aligned rows.  VideoPacket::stride has
+        /// the resulting row pitch.  1 (the default) keeps rows packed.  Takes effect with the next
+        /// converted frame and is passed on to a frame sink as the stride it starts from.
+        void SetRowAlignment(int Bytes);
         const State GetState();
         const std::chrono::microseconds GetVideoFrameTime();
         const int GetAudioChannelCount();
@@ -118,7 +331,77 @@ namespace mt
         void SetPlayingOffset(std::chrono::microseconds PlayingOffset);
         void Update();
         const float GetPlaybackSpeed();
+        /// Clamped to 0.25x - 16x.  Audio is time stretched keeping its pitch, past 2x the decoder
+        /// skips non reference frames and past 8x everything but key frames.
         void SetPlaybackSpeed(float PlaybackSpeed);
         const bool IsEndofFileReached();
+        const PlaybackDirection GetPlaybackDirection();
+        /// Reverse playback decodes a GOP at a time forward into a cache and presents it backwards.
+        /// The GOP before it is decoded on the same decode thread (or scheduler task) while the
+        /// current one plays, handing cached frames to the playbacks between packets rather than
+        /// on a second worker, so one reverse source never uses more than one core.  A GOP that
+        /// takes longer to decode than the one before it takes to play stalls playback until it is
+        /// done.  Audio is silent in reverse.
+        void SetPlaybackDirection(PlaybackDirection Direction);
+        const std::size_t GetReverseCacheLimit();
+        /// Bytes of converted frames reverse playback may hold, GOPs larger than half of it are
+        /// decoded in several passes.
+        void SetReverseCacheLimit(std::size_t Bytes);
+        /// Pause and show the next or previous frame, waits for the decoder if it has to.
+        /// Returns false at either end of the file.
+        bool StepForward();
+        bool StepBackward();
+        const bool IsLooping();
+        /// Plays the file, or the range set with SetLoopRange, over and over.  The decoder seeks
+        /// back by itself and keeps the queues fed across the wrap from the first frames of the
+        /// loop, which it keeps decoded, so the wrap costs no frame time.  The playing offset
+        /// keeps counting up inside the player and GetPlayingOffset() reports it within the loop.
+        /// Forward playback only.
+        void SetLooping(bool Looping);
+        const std::chrono::microseconds GetLoopStart();
+        const std::chrono::microseconds GetLoopEnd();
+        /// An End of zero loops to the end of the file.
+        void SetLoopRange(std::chrono::microseconds Start, std::chrono::microseconds End);
+        const std::size_t GetFrameCacheLimit();
+        /// Bytes of converted frames kept for seeking and stepping back to, zero (the default)
+        /// turns the cache off.  Seeks it can serve while not playing leave the decoder alone.
+        void SetFrameCacheLimit(std::size_t Bytes);
+        const std::string GetVideoFilter();
+        /// Runs every decoded frame through a libavfilter graph, "yadif,crop=iw/2:ih/2:0:0" or
+        /// "transpose=1,eq=brightness=0.1", with the conversion to RGBA as the last step of the
+        /// same graph.  GetVideoSize() reports the filtered size.  Takes effect from the current
+        /// position, an empty string turns it off.  A graph that fails to build returns false and
+        /// leaves the previous one in place.
+        bool SetVideoFilter(const std::string& Description);
+        const QueueLimits GetQueueLimits();
+        /// Takes effect with the next decoded frame.
+        void SetQueueLimits(const QueueLimits& Limits);
+        const DecodeMode GetDecodeMode();
+        void SetDecodeMode(DecodeMode Mode);
+        const DecodePriority GetPriority();
+        void SetPriority(DecodePriority Priority);
+        /// When the emptiest video playback runs dry, time_point::max() while nothing is due.
+        const std::chrono::steady_clock::time_point GetNextDeadline();
+        const unsigned int GetDeadlineMissCount();
+        /// With a master clock set the playing offset follows the samples that playback's device
+        /// has consumed and video is presented by timestamp against it, nullptr uses the wall clock.
+        void SetMasterClock(AudioPlayback* Playback);
+        AudioPlayback* GetMasterClock();
+        /// Callback gets the timestamp of every frame the decoder queues for the playbacks, and of a
+        /// cached frame presented by a seek, so a renderer only has to update sources that have
+        /// something new.  It runs through Executor, or right on the decode thread without one, and
+        /// must not call back into the source there.  The source has to outlive the tasks it hands
+        /// to the executor.  An empty callback turns it off.
+        void SetFrameReadyCallback(FrameReadyCallback Callback, Executor Executor = mt::Executor());
+        /// Callback runs on every change between playing, paused and stopped, seeks and the end of
+        /// the file included, through Executor or on the thread that caused the change.
+        void SetStateChangedCallback(StateChangedCallback Callback, Executor Executor = mt::Executor());
+        /// Linux only, -1 elsewhere.  An eventfd for epoll and friends that turns readable on the
+        /// same events as the callbacks above.  Opened by the first call and closed with the source.
+        /// Reading it or calling ClearReady() resets it.
+        const int GetReadyFd();
+        void ClearReady();
+        const DataSourceStats GetStats();
+        void ResetStats();
     };
 }
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "include/NonCopyable.h"
+
+namespace mt
+{
+    class DataSource;
+
+    enum class DecodeMode
+    {
+        DedicatedThread,
+        SharedScheduler
+    };
+
+    enum class DecodePriority
+    {
+        Low,
+        Normal,
+        High
+    };
+
+    /// Process wide pool of decode workers, sized to the core count.  Sources running in
+    /// DecodeMode::SharedScheduler submit themselves as tasks instead of owning a thread.
+    /// A source is only ever decoded by one worker at a time so its packet order is preserved.
+    /// Sources are queued on the worker that submitted them, but a worker picks the most urgent
+    /// source out of all queues: highest DecodePriority first, then the one whose next frame is
+    /// due soonest.  A source passed over a few times in a row goes first regardless, so none of
+    /// them starves.
+    class DecodeScheduler : private mt::NonCopyable
+    {
+        friend class DataSource;
+
+    private:
+        struct Worker
+        {
+            std::mutex lock;
+            std::deque<DataSource*> tasks;
+        };
+
+        std::vector<std::unique_ptr<Worker>> m_workers;
+        std::vector<std::thread> m_threads;
+        std::mutex m_waitlock;
+        std::condition_variable m_waitcondition;
+        std::atomic<bool> m_shouldrun;
+        std::atomic<std::size_t> m_nextworker;
+        std::atomic<std::size_t> m_pendingcount;
+
+        DecodeScheduler();
+        ~DecodeScheduler();
+        void Submit(DataSource* Source);
+        void Cancel(DataSource* Source);
+        bool RemoveQueued(DataSource* Source);
+        bool TryPop(std::size_t WorkerIndex, DataSource*& Source);
+        static bool IsMoreUrgent(DataSource* Source, DataSource* Other);
+        void Enqueue(std::size_t WorkerIndex, DataSource* Source);
+        void WorkerRun(std::size_t WorkerIndex);
+
+    public:
+        static DecodeScheduler& GetInstance();
+        const std::size_t GetWorkerCount();
+    };
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <functional>
+
+namespace mt
+{
+    /// Runs a task on the caller's terms, a thread pool, job system or event loop.  An empty
+    /// executor runs the task inline on whichever thread completed the work.
+    typedef std::function<void(std::function<void()>)> Executor;
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <iterator>
+#include <mutex>
+
+#include "include/DataSource.hpp"
+#include "include/Executor.hpp"
+#include "include/VideoPlayback.hpp"
+#include "include/priv/VideoPacket.hpp"
+#include "include/NonCopyable.h"
+
+#if defined(__has_include)
+#if __has_include(<coroutine>) && defined(__cpp_impl_coroutine)
+#include <coroutine>
+#define MOTIONLESS_COROUTINES 1
+#endif
+#endif
+
+namespace mt
+{
+    class DataSource;
+
+    /// Pulls every decoded frame of a source in order as fast as it can be decoded, for analysis
+    /// and export.  There is no clock and nothing is dropped, the decoder only runs ahead as far
+    /// as the queue allows and waits for the next NextFrame() to make room.  The source should
+    /// not be played or updated while a reader is attached.
+    class FrameReader : private mt::NonCopyable
+    {
+        friend class DataSource;
+
+    public:
+        typedef std::function<void(priv::VideoPacketPtr)> FrameCallback;
+
+        class Iterator
+        {
+        private:
+            FrameReader* m_reader;
+            priv::VideoPacketPtr m_frame;
+
+        public:
+            typedef std::input_iterator_tag iterator_category;
+            typedef priv::VideoPacketPtr value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef const priv::VideoPacketPtr* pointer;
+            typedef const priv::VideoPacketPtr& reference;
+
+            Iterator();
+            explicit Iterator(FrameReader& Reader);
+            reference operator*() const;
+            pointer operator->() const;
+            Iterator& operator++();
+            bool operator==(const Iterator& Other) const;
+            bool operator!=(const Iterator& Other) const;
+        };
+
+    private:
+        VideoPlayback m_playback;
+
+    public:
+        FrameReader(DataSource& DataSource);
+        ~FrameReader();
+        /// Blocks until the next frame is decoded, nullptr once the end of the file is reached.
+        priv::VideoPacketPtr NextFrame();
+        /// Takes the next frame only if one is already decoded, Frame stays nullptr at the end.
+        bool TryNextFrame(priv::VideoPacketPtr& Frame);
+        /// Non blocking NextFrame(), Callback gets the frame or nullptr at the end through Executor
+        /// as soon as it is decoded.  One request may be outstanding at a time and the reader has to
+        /// outlive it.
+        void RequestNextFrame(FrameCallback Callback, Executor Executor = mt::Executor());
+        /// Range-for over the remaining frames, starting from the current playing offset.
+        Iterator begin();
+        Iterator end();
+        const uint64_t GetReadFrameCount();
+
+#ifdef MOTIONLESS_COROUTINES
+        /// co_await reader.NextFrameAsync(executor) suspends without blocking a thread until the
+        /// next frame is decoded and resumes on the executor.
+        class FrameAwaiter
+        {
+        private:
+            FrameReader* m_reader;
+            Executor m_executor;
+            priv::VideoPacketPtr m_frame;
+
+        public:
+            FrameAwaiter(FrameReader& Reader, Executor Executor) :
+                m_reader(&Reader),
+                m_executor(std::move(Executor)),
+                m_frame()
+            { }
+
+            bool await_ready()
+            {
+                return m_reader->TryNextFrame(m_frame);
+            }
+
+            void await_suspend(std::coroutine_handle<> Handle)
+            {
+                m_reader->RequestNextFrame([this, Handle](priv::VideoPacketPtr Frame)
+                {
+                    m_frame = std::move(Frame);
+                    Handle.resume();
+                }, m_executor);
+            }
+
+            priv::VideoPacketPtr await_resume()
+            {
+                return std::move(m_frame);
+            }
+        };
+
+        /// Asynchronous sequence of frames:
+        /// `auto frames = reader.Frames(executor); while (co_await frames.Next()) Use(frames.Current());`
+        class FrameSequence
+        {
+        private:
+            FrameReader* m_reader;
+            Executor m_executor;
+            priv::VideoPacketPtr m_current;
+
+            class NextAwaiter
+            {
+            private:
+                FrameSequence* m_sequence;
+                FrameAwaiter m_awaiter;
+
+            public:
+                NextAwaiter(FrameSequence& Sequence) :
+                    m_sequence(&Sequence),
+                    m_awaiter(*Sequence.m_reader, Sequence.m_executor)
+                { }
+
+                bool await_ready() { return m_awaiter.await_ready(); }
+                void await_suspend(std::coroutine_handle<> Handle) { m_awaiter.await_suspend(Handle); }
+                bool await_resume()
+                {
+                    m_sequence->m_current = m_awaiter.await_resume();
+                    return m_sequence->m_current != nullptr;
+                }
+            };
+
+        public:
+            FrameSequence(FrameReader& Reader, Executor Executor) :
+                m_reader(&Reader),
+                m_executor(std::move(Executor)),
+                m_current()
+            { }
+
+            NextAwaiter Next() { return NextAwaiter(*this); }
+            const priv::VideoPacketPtr& Current() const { return m_current; }
+        };
+
+        FrameAwaiter NextFrameAsync(Executor Executor = mt::Executor())
+        {
+            return FrameAwaiter(*this, std::move(Executor));
+        }
+
+        FrameSequence Frames(Executor Executor = mt::Executor())
+        {
+            return FrameSequence(*this, std::move(Executor));
+        }
+#endif
+    };
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+namespace mt
+{
+    /// Supplies the memory converted frames are written to, a persistently mapped upload buffer
+    /// for example, so the scaler writes every frame straight into it and nothing is copied on the
+    /// way to the GPU.  A frame's buffer is held for as long as the frame is, in the playback
+    /// queues, the frame cache, reverse playback and the loop prefetch, and given back once the
+    /// last reference is gone.  A sink that runs out returns nullptr and the frame goes to the
+    /// library's own memory instead.
+    class FrameSink
+    {
+    public:
+        virtual ~FrameSink() { }
+        /// Decode thread.  Memory for a Width x Height RGBA frame with rows Stride bytes apart,
+        /// Stride comes in as Width * 4 rounded up to the source's row alignment and may be raised.
+        virtual uint8_t* AcquireBuffer(int Width, int Height, int& Stride) = 0;
+        /// Any thread, the frame written into Buffer is no longer used.
+        virtual void ReleaseBuffer(uint8_t* Buffer) = 0;
+    };
+
+    typedef std::shared_ptr<FrameSink> FrameSinkPtr;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "include/priv/MemoryAccount.hpp"
+#include "include/NonCopyable.h"
+
+namespace mt
+{
+    class DataSource;
+
+    class SourceMemory
+    {
+    public:
+        const DataSource* source;
+        std::size_t stagingbytes;
+        std::size_t framebytes;
+        std::size_t audiobytes;
+        std::size_t totalbytes;
+
+        SourceMemory();
+    };
+
+    /// Process wide accounting of the memory held by every source.  Frames, staging buffers and
+    /// audio rings are charged to their source's account as they are allocated.  Once the total
+    /// goes over the cap, low priority sources stop decoding, everything else shrinks its queue
+    /// to the minimum and the frame caches stop growing until memory is released again.
+    class MemoryGovernor : private mt::NonCopyable
+    {
+        friend class DataSource;
+        friend class priv::MemoryAccount;
+
+    private:
+        std::atomic<std::size_t> m_limit;
+        std::atomic<std::size_t> m_used;
+        std::mutex m_lock;
+        std::vector<std::weak_ptr<priv::MemoryAccount>> m_accounts;
+
+        MemoryGovernor();
+        priv::MemoryAccountPtr CreateAccount(const DataSource* Source);
+
+    public:
+        static MemoryGovernor& GetInstance();
+        const std::size_t GetLimit();
+        /// Zero (the default) leaves memory uncapped, it is still accounted.
+        void SetLimit(std::size_t Bytes);
+        const std::size_t GetUsedBytes();
+        const bool IsOverLimit();
+        /// One entry per live account, sources that are gone but whose frames are still held
+        /// show up with a null source.
+        const std::vector<SourceMemory> GetBreakdown();
+    };
+}
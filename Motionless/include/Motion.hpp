@@ -1,5 +1,12 @@
 #pragma once
 
 #include "DataSource.hpp"
+#include "DecodeScheduler.hpp"
+#include "FrameSink.hpp"
+#include "MemoryGovernor.hpp"
+#include "PlaybackStats.hpp"
+#include "Trace.hpp"
 #include "AudioPlayback.hpp"
-#include "VideoPlayback.hpp"
\ No newline at end of file
+#include "VideoPlayback.hpp"
+#include "FrameReader.hpp"
+#include "Playlist.hpp"
\ No newline at end of file
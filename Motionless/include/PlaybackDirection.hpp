@@ -0,0 +1,10 @@
+#pragma once
+
+namespace mt
+{
+    enum class PlaybackDirection
+    {
+        Forward,
+        Reverse
+    };
+}
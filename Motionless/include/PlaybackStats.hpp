@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace mt
+{
+    /// Snapshot of a timing histogram.  Bucket 0 holds samples under 1us, bucket i holds
+    /// samples in [2^(i-1), 2^i) microseconds and the last bucket holds everything longer.
+    class TimeHistogram
+    {
+    public:
+        static const std::size_t BucketCount = 24;
+
+        std::array<uint64_t, BucketCount> buckets;
+        uint64_t count;
+        std::chrono::microseconds total;
+        std::chrono::microseconds max;
+
+        TimeHistogram();
+        const std::chrono::microseconds GetAverage() const;
+        const std::chrono::microseconds GetPercentile(double Percentile) const;
+    };
+
+    class VideoPlaybackStats
+    {
+    public:
+        uint64_t presentedframes;
+        uint64_t droppedframes;
+        uint64_t deadlinemisses;
+        std::size_t queuedepth;
+        std::size_t queuedepthhighwater;
+
+        VideoPlaybackStats();
+    };
+
+    class DataSourceStats
+    {
+    public:
+        uint64_t decodedvideoframes;
+        uint64_t decodedaudioframes;
+        uint64_t convertedframes;
+        uint64_t presentedframes;
+        uint64_t droppedframes;
+        uint64_t deadlinemisses;
+        uint64_t bytesread;
+        uint64_t seekcount;
+        std::size_t queuedepthhighwater;
+        /// Last measured distance between the audio timestamps and the samples actually
+        /// produced, positive when the stream is ahead and samples are being stretched in.
+        std::chrono::microseconds audiodrift;
+        uint64_t audiodriftcorrections;
+        uint64_t audioresyncs;
+        uint64_t framecachehits;
+        uint64_t framecachemisses;
+        std::size_t framecachebytes;
+        /// Times a looping source went back to the start of its loop.
+        uint64_t loopwraps;
+        /// Current adaptive queue limits, video in frames and audio in sample frames, sized to
+        /// cover queuetarget of playback.
+        std::size_t videoqueuelimit;
+        std::size_t audioqueuelimit;
+        std::chrono::microseconds queuetarget;
+        /// Bytes held by this source: decode and conversion buffers and parked packets, queued
+        /// frames, queued audio and memorybytes as everything charged to its MemoryGovernor
+        /// account, caches, presented frame copies and audio rings included.
+        std::size_t stagingbytes;
+        std::size_t videoqueuebytes;
+        std::size_t audioqueuebytes;
+        std::size_t memorybytes;
+        /// Compressed packets the demuxer read past a full stream while the other one needed data.
+        std::size_t parkedpackets;
+        std::size_t parkedbytes;
+        TimeHistogram readtime;
+        TimeHistogram decodetime;
+        TimeHistogram converttime;
+        /// Copies made on the decode thread.  Only a filter graph's output is copied, the scaler
+        /// writes straight into the packet, and presenting a frame shares it instead of copying.
+        TimeHistogram decodecopytime;
+        TimeHistogram seeklatency;
+
+        DataSourceStats();
+    };
+}
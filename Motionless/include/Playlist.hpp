@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "include/AudioPlayback.hpp"
+#include "include/DataSource.hpp"
+#include "include/State.hpp"
+#include "include/VideoPlayback.hpp"
+#include "include/priv/VideoPacket.hpp"
+#include "include/NonCopyable.h"
+
+namespace mt
+{
+    /// Plays a list of files back to back without a gap.  While one item plays the next one is
+    /// opened and decoded up to its first frames on a background thread, once the last frame of
+    /// the current item has been shown for its frame time the next one takes over in the same
+    /// Update() with the time that ran over carried into it.  Items are loaded into sources of
+    /// their own, so the playlist stands in for the source and its playbacks: call Update() from
+    /// the render thread, GetLastPacket() for the picture and ReadSamples() from the audio
+    /// device.  Items are expected to share their audio format.  Everything but ReadSamples() is
+    /// called from one thread.
+    class Playlist : private mt::NonCopyable
+    {
+    public:
+        typedef std::function<void(DataSource& Source)> SourceCallback;
+
+    private:
+        /// A loaded item with the consumers the playlist reads it through.
+        class Entry
+        {
+        public:
+            std::size_t index;
+            std::unique_ptr<DataSource> source;
+            std::unique_ptr<VideoPlayback> video;
+            std::unique_ptr<AudioPlayback> audio;
+        };
+
+        bool m_enablevideo;
+        bool m_enableaudio;
+        std::mutex m_itemlock;
+        std::vector<std::string> m_items;
+        SourceCallback m_sourcecallback;
+        std::atomic<bool> m_looping;
+        std::atomic<float> m_playbackspeed;
+        State m_state;
+        bool m_endreached;
+        std::unique_ptr<Entry> m_current;
+        std::mutex m_audiolock;
+        AudioPlayback* m_currentaudio;
+        std::mutex m_preloadlock;
+        std::unique_ptr<std::thread> m_preloadthread;
+        std::unique_ptr<Entry> m_next;
+        std::unique_ptr<Entry> m_retired;
+        std::atomic<bool> m_preloadready;
+        std::atomic<bool> m_cancelpreload;
+        std::atomic<uint64_t> m_transitioncount;
+        std::atomic<uint64_t> m_latetransitioncount;
+        bool m_waitingfornext;
+        std::atomic<int> m_channelcount;
+        std::atomic<int> m_samplerate;
+        priv::VideoPacketPtr m_lastpacket;
+
+        std::unique_ptr<Entry> LoadEntry(std::size_t Index, bool Preroll);
+        bool GetNextIndex(std::size_t Index, std::size_t& NextIndex);
+        void StartPreload(std::size_t Index);
+        void StopPreload();
+        void PreloadRun(std::size_t Index);
+        bool IsItemFinished(Entry& Item, std::chrono::microseconds& Overrun);
+        void MakeCurrent(std::unique_ptr<Entry> Item, std::chrono::microseconds Overrun);
+
+    public:
+        Playlist(bool EnableVideo = true, bool EnableAudio = true);
+        ~Playlist();
+        void Add(const std::string& Filename);
+        /// Stops playback and empties the list.
+        void Clear();
+        const std::size_t GetItemCount();
+        /// Index of the item playing, -1 before the first one is loaded.
+        const int GetCurrentItem();
+        /// Loads the item right away, a cold switch, and starts preloading the one after it.
+        bool SetCurrentItem(std::size_t Index);
+        /// Starts over from the first item once the last one ends.
+        const bool IsLooping();
+        void SetLooping(bool Looping);
+        /// Called on the loading thread for every item once its file is open and before it is
+        /// pre-rolled, to apply filters, regions or limits.  Set it before the first item loads.
+        void SetSourceCallback(SourceCallback Callback);
+        void Play();
+        void Pause();
+        void Stop();
+        const State GetState();
+        const float GetPlaybackSpeed();
+        void SetPlaybackSpeed(float PlaybackSpeed);
+        /// Drives the current item and swaps in the next one when its time comes.
+        void Update();
+        /// True once the last item ended and looping is off.
+        const bool IsEndofPlaylistReached();
+        /// The current item's source, valid until the next Update(), SetCurrentItem() or Clear().
+        DataSource* GetCurrentSource();
+        /// Latest frame shown, the last one of an item stays up until the next item shows its first.
+        priv::VideoPacket* GetLastPacket() const;
+        /// Real time safe, see AudioPlayback::ReadSamples().  A call that races a switch of items
+        /// gets silence rather than waiting.
+        std::size_t ReadSamples(int16_t* Destination, std::size_t FrameCount);
+        const int GetChannelCount();
+        const int GetSampleRate();
+        /// Switches from one item to the next.
+        const uint64_t GetTransitionCount();
+        /// Of those, the ones that had to wait for the next item to finish loading and left a gap.
+        const uint64_t GetLateTransitionCount();
+    };
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+namespace mt
+{
+    /// Bounds for how far the decoder may run ahead of playback.  The queue is sized to cover a
+    /// target duration, minduration plus a margin for the measured decode time jitter capped at
+    /// maxduration, then limited by maxframes and maxbytes.  minframes always wins so the decoder
+    /// never stalls on a single huge frame.  Audio and video are bounded separately, while one
+    /// stream is full the demuxer keeps reading for the other and parks the full stream's packets
+    /// compressed, up to maxparkedbytes.
+    class QueueLimits
+    {
+    public:
+        std::size_t minframes;
+        std::size_t maxframes;
+        std::size_t maxbytes;
+        std::chrono::microseconds minduration;
+        std::chrono::microseconds maxduration;
+        std::size_t maxparkedbytes;
+
+        QueueLimits();
+    };
+}
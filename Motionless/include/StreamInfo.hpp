@@ -0,0 +1,36 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+namespace mt
+{
+    enum class StreamType
+    {
+        Video,
+        Audio,
+        Subtitle,
+        Other
+    };
+
+    /// One stream of the loaded file as listed by DataSource::GetStreams(), index is what
+    /// SelectStreams takes.  Fields that do not apply to the stream type stay zero.
+    class StreamInfo
+    {
+    public:
+        int index;
+        StreamType type;
+        std::string codec;
+        std::string language;
+        std::string title;
+        bool isdefault;
+        bool selected;
+        int width;
+        int height;
+        int samplerate;
+        int channelcount;
+        std::chrono::microseconds duration;
+
+        StreamInfo();
+    };
+}
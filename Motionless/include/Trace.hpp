@@ -0,0 +1,26 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+namespace mt
+{
+    /// Opt-in timeline of the decode pipeline.  Define MOTIONLESS_TRACING when building the
+    /// library to compile the trace points in, otherwise they expand to nothing and every
+    /// function here is a no-op that returns false.
+    class Trace
+    {
+    public:
+        static const bool IsCompiledIn();
+        static void Start();
+        static void Stop();
+        /// Drops the events recorded so far.  Safe while recording, each thread discards its own
+        /// events with the next one it records.
+        static void Clear();
+        static const bool IsRecording();
+        /// Writes the events overlapping [From, To] in the Chrome trace event format, loadable
+        /// by chrome://tracing and the Perfetto UI.  Call Stop() first for a consistent dump.
+        static bool WriteChromeTrace(const std::string& Filename);
+        static bool WriteChromeTrace(const std::string& Filename, std::chrono::steady_clock::time_point From, std::chrono::steady_clock::time_point To);
+    };
+}
@@ -3,41 +3,42 @@
 #include <memory>
 #include <queue>
 #include <cmath>
+#include <condition_variable>
 
 #include "include/DataSource.hpp"
 #include "include/State.hpp"
+#include "include/priv/VideoConsumer.hpp"
 #include "include/priv/VideoPacket.hpp"
 #include "include/NonCopyable.h"
+#include "include/PlaybackStats.hpp"
 
 #include <chrono>
 
 namespace mt
 {
     class DataSource;
+    class FrameReader;
+    class Playlist;
 
     class VideoPlayback : private mt::NonCopyable
     {
         friend class DataSource;
+        friend class FrameReader;
+        friend class Playlist;
 
     private:
-        DataSource* m_datasource;
-        std::mutex m_protectionlock;
-        std::queue<priv::VideoPacketPtr> m_queuedvideopackets;
-		std::chrono::microseconds m_elapsed;
-		std::chrono::microseconds m_frametime;
-        int m_framejump;
-		
-        unsigned int m_playedframecount;
-
-        void SourceReloaded();
-        void StateChanged(State PreviousState, State NewState);
-        void Update(std::chrono::microseconds DeltaTime);
-		std::unique_ptr<mt::priv::VideoPacket> m_lastpacket;
+        priv::VideoConsumerPtr m_consumer;
 
     public:
         VideoPlayback(DataSource& DataSource);
         ~VideoPlayback();
         unsigned int GetPlayedFrameCount() const;
+        unsigned int GetDeadlineMissCount() const;
+        const VideoPlaybackStats GetStats();
 	    priv::VideoPacket* GetLastPacket() const;
+        /// Linux only, -1 elsewhere.  An eventfd that turns readable when a frame is queued for this
+        /// playback or the source's state changes, see DataSource::GetReadyFd().
+        const int GetReadyFd();
+        void ClearReady();
     };
 }
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "include/State.hpp"
+#include "include/priv/MemoryAccount.hpp"
+#include "include/priv/RingBuffer.hpp"
+#include "include/NonCopyable.h"
+
+namespace mt
+{
+    class DataSource;
+    class AudioPlayback;
+
+    namespace priv
+    {
+        /// The part of an AudioPlayback the decode thread writes into and the audio device reads
+        /// from, shared the same way as VideoConsumer so the playback can go away while the
+        /// decode thread is still writing through an older list of consumers.
+        class AudioConsumer : private mt::NonCopyable
+        {
+            friend class mt::DataSource;
+            friend class mt::AudioPlayback;
+
+        private:
+            /// Ring position from which on the written samples play at Tempo, starting at Pts.
+            class ClockAnchor
+            {
+            public:
+                uint64_t position;
+                std::chrono::microseconds pts;
+                float tempo;
+            };
+
+            mt::AudioPlayback* m_playback;
+            std::atomic<int> m_channelcount;
+            std::atomic<std::size_t> m_targetbufferedframes;
+            std::chrono::microseconds m_offsetcorrection;
+            DataSource* m_datasource;
+            std::mutex m_protectionlock;
+            RingBuffer<int16_t> m_samples;
+            std::vector<int16_t> m_overflow;
+            MemoryAccountPtr m_memory;
+            std::atomic<bool> m_playing;
+            std::atomic<float> m_volume;
+            std::atomic<uint64_t> m_consumedframecount;
+            std::atomic<uint64_t> m_underruncount;
+            std::mutex m_clocklock;
+            std::deque<ClockAnchor> m_clockanchors;
+
+            void SourceReloaded();
+            void StateChanged(State PreviousState, State NewState);
+            bool IsBufferFull();
+            void Flush();
+            std::chrono::microseconds GetAnchorTime(const ClockAnchor& Anchor, uint64_t Position);
+            void WriteSamples(const int16_t* Samples, std::size_t FrameCount, std::chrono::microseconds Pts, float Tempo);
+            void WriteOverflow();
+            std::size_t ReadSamples(int16_t* Destination, std::size_t FrameCount);
+            const int GetSampleRate();
+            const std::size_t GetBufferedFrameCount();
+            const bool HasClock();
+            const std::chrono::microseconds GetClock();
+            const std::chrono::microseconds GetOffsetCorrection();
+            void SetOffsetCorrection(std::chrono::microseconds OffsetCorrection);
+
+        public:
+            AudioConsumer(DataSource& DataSource, mt::AudioPlayback& Playback, std::chrono::microseconds OffsetCorrection);
+            ~AudioConsumer();
+        };
+
+        typedef std::shared_ptr<AudioConsumer> AudioConsumerPtr;
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+#include "include/NonCopyable.h"
+
+extern "C"
+{
+#include <libavfilter/avfilter.h>
+#include <libavfilter/buffersink.h>
+#include <libavfilter/buffersrc.h>
+#include <libavutil/frame.h>
+}
+
+namespace mt
+{
+    namespace priv
+    {
+        /// Time stretches interleaved signed 16 bit PCM without changing its pitch through a
+        /// chain of libavfilter atempo filters, each of which only covers 0.5x to 2x.  At a
+        /// tempo of 1 no graph exists and the decoder writes its samples straight through.
+        class AudioTempo : private mt::NonCopyable
+        {
+        private:
+            AVFilterGraph* m_graph;
+            AVFilterContext* m_source;
+            AVFilterContext* m_sink;
+            AVFrame* m_input;
+            AVFrame* m_output;
+            float m_tempo;
+            int m_samplerate;
+            uint64_t m_channellayout;
+            int64_t m_nextpts;
+
+            bool CreateGraph();
+
+        public:
+            typedef std::function<void(const int16_t* Samples, int FrameCount)> OutputCallback;
+
+            AudioTempo();
+            ~AudioTempo();
+            /// Rebuilds the chain when anything changed, samples still inside the old one are dropped.
+            bool Configure(int SampleRate, uint64_t ChannelLayout, float Tempo);
+            /// Frees the chain and goes back to passing samples through.
+            void Reset();
+            float GetTempo() const;
+            bool IsActive() const;
+            /// Feeds FrameCount frames in and hands every frame that comes out to Output.
+            bool Process(const int16_t* Samples, int FrameCount, const OutputCallback& Output);
+        };
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <mutex>
+
+#include "include/priv/VideoPacket.hpp"
+#include "include/NonCopyable.h"
+
+namespace mt
+{
+    namespace priv
+    {
+        /// Least recently used cache of converted frames keyed by presentation time, bounded by
+        /// the bytes of pixel data it keeps alive.  The decode thread inserts every frame it
+        /// converts, seeks and steps look frames up before falling back to the decoder.
+        class FrameCache : private mt::NonCopyable
+        {
+        private:
+            class Entry
+            {
+            public:
+                VideoPacketPtr packet;
+                std::list<int64_t>::iterator recent;
+            };
+
+            std::mutex m_lock;
+            std::map<int64_t, Entry> m_entries;
+            std::list<int64_t> m_recent;
+            std::size_t m_bytes;
+            std::size_t m_limit;
+
+            static std::size_t GetPacketBytes(const VideoPacketPtr& Packet);
+            VideoPacketPtr Touch(std::map<int64_t, Entry>::iterator Found);
+            void Evict();
+
+        public:
+            FrameCache();
+            void Insert(const VideoPacketPtr& Packet);
+            /// The frame on screen at Position, one that started less than Tolerance before it.
+            VideoPacketPtr FindAt(std::chrono::microseconds Position, std::chrono::microseconds Tolerance);
+            /// The frame following or preceding Pts, only if it is no further away than Tolerance
+            /// so a gap in the cache is never mistaken for the neighbouring frame.
+            VideoPacketPtr FindNext(std::chrono::microseconds Pts, std::chrono::microseconds Tolerance);
+            VideoPacketPtr FindPrevious(std::chrono::microseconds Pts, std::chrono::microseconds Tolerance);
+            void Clear();
+            std::size_t GetBytes();
+            std::size_t GetLimit();
+            /// Zero disables the cache and drops everything in it.
+            void SetLimit(std::size_t Bytes);
+        };
+    }
+}
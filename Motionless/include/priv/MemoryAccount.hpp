@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+#include "include/NonCopyable.h"
+
+namespace mt
+{
+    class DataSource;
+
+    enum class MemoryCategory
+    {
+        /// Decode, conversion and resampling buffers.
+        Staging,
+        /// Converted frames wherever they are held: queues, caches and the frame on screen.
+        Frames,
+        /// Audio sample rings.
+        Audio
+    };
+
+    namespace priv
+    {
+        /// Bytes one source holds, by category.  Every charge also counts against the
+        /// MemoryGovernor's process wide total.  Frames keep the account alive, so memory they
+        /// hold after their source is gone is still released against it.
+        class MemoryAccount : private mt::NonCopyable
+        {
+        private:
+            static const std::size_t CategoryCount = 3;
+
+            std::atomic<const DataSource*> m_source;
+            std::array<std::atomic<std::size_t>, CategoryCount> m_bytes;
+
+        public:
+            MemoryAccount(const DataSource* Source);
+            void Charge(MemoryCategory Category, std::size_t Bytes);
+            void Release(MemoryCategory Category, std::size_t Bytes);
+            const std::size_t GetBytes(MemoryCategory Category);
+            const std::size_t GetTotalBytes();
+            /// nullptr once the source is destroyed.
+            const DataSource* GetSource();
+            void Detach();
+        };
+
+        typedef std::shared_ptr<MemoryAccount> MemoryAccountPtr;
+    }
+}
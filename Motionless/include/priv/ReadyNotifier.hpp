@@ -0,0 +1,31 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+
+#include "include/NonCopyable.h"
+
+namespace mt
+{
+    namespace priv
+    {
+        /// Pollable readiness flag for hosts running their own event loop.  On Linux it is an
+        /// eventfd opened on first request, Signal() makes it readable and Clear() or reading it
+        /// resets it.  Elsewhere, and until someone asks for it, there is no descriptor and
+        /// Signal() is a single atomic load.
+        class ReadyNotifier : private mt::NonCopyable
+        {
+        private:
+            std::mutex m_lock;
+            std::atomic<int> m_fd;
+
+        public:
+            ReadyNotifier();
+            ~ReadyNotifier();
+            /// Opens the descriptor if needed, -1 where eventfd is not available.
+            int GetFd();
+            void Signal();
+            void Clear();
+        };
+    }
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+namespace mt
+{
+    namespace priv
+    {
+        /// Wait free single producer / single consumer ring of trivially copyable values.
+        /// Indices only ever grow, so no slot is wasted and full/empty are never ambiguous.
+        /// Flush() may be called by the producer side (or any thread while the producer is
+        /// stopped) to drop everything written so far, the consumer skips it on its next read.
+        /// Other threads RequestFlush() and the producer carries it out in ApplyFlush().  Flushed
+        /// slots only become writable again once the consumer skipped them, it may still be
+        /// copying out of them.
+        template <typename T>
+        class RingBuffer
+        {
+        private:
+            std::unique_ptr<T[]> m_buffer;
+            std::size_t m_capacity;
+            std::size_t m_mask;
+            std::atomic<uint64_t> m_writeindex;
+            std::atomic<uint64_t> m_readindex;
+            std::atomic<uint64_t> m_flushindex;
+            std::atomic<bool> m_flushrequested;
+
+            uint64_t GetConsumerStart() const
+            {
+                return std::max(m_readindex.load(std::memory_order_relaxed), m_flushindex.load(std::memory_order_acquire));
+            }
+
+        public:
+            /// Capacity is rounded up to the next power of two.
+            RingBuffer(std::size_t Capacity) :
+                m_buffer(),
+                m_capacity(1),
+                m_mask(0),
+                m_writeindex(0),
+                m_readindex(0),
+                m_flushindex(0),
+                m_flushrequested(false)
+            {
+                while (m_capacity < Capacity) m_capacity <<= 1;
+                m_mask = m_capacity - 1;
+                m_buffer.reset(new T[m_capacity]);
+            }
+
+            RingBuffer(const RingBuffer&) = delete;
+            RingBuffer& operator=(const RingBuffer&) = delete;
+
+            std::size_t GetCapacity() const
+            {
+                return m_capacity;
+            }
+
+            /// Producer side, returns how many values fit.
+            std::size_t Write(const T* Source, std::size_t Count)
+            {
+                uint64_t write = m_writeindex.load(std::memory_order_relaxed);
+                uint64_t read = m_readindex.load(std::memory_order_acquire);
+                std::size_t count = std::min<std::size_t>(Count, m_capacity - static_cast<std::size_t>(write - read));
+                std::size_t offset = static_cast<std::size_t>(write & m_mask);
+                std::size_t first = std::min(count, m_capacity - offset);
+                std::memcpy(&m_buffer[offset], Source, first * sizeof(T));
+                std::memcpy(&m_buffer[0], Source + first, (count - first) * sizeof(T));
+                m_writeindex.store(write + count, std::memory_order_release);
+                return count;
+            }
+
+            /// Consumer side, returns how many values were copied out.
+            std::size_t Read(T* Destination, std::size_t Count)
+            {
+                uint64_t read = GetConsumerStart();
+                uint64_t write = m_writeindex.load(std::memory_order_acquire);
+                std::size_t count = std::min<std::size_t>(Count, static_cast<std::size_t>(write - read));
+                std::size_t offset = static_cast<std::size_t>(read & m_mask);
+                std::size_t first = std::min(count, m_capacity - offset);
+                std::memcpy(Destination, &m_buffer[offset], first * sizeof(T));
+                std::memcpy(Destination + first, &m_buffer[0], (count - first) * sizeof(T));
+                m_readindex.store(read + count, std::memory_order_release);
+                return count;
+            }
+
+            std::size_t GetReadAvailable() const
+            {
+                uint64_t write = m_writeindex.load(std::memory_order_acquire);
+                uint64_t read = std::max(m_readindex.load(std::memory_order_acquire), m_flushindex.load(std::memory_order_acquire));
+                return static_cast<std::size_t>(write - std::min(read, write));
+            }
+
+            /// Consumer side, lets go of flushed values without reading anything.
+            void SkipFlushed()
+            {
+                uint64_t read = GetConsumerStart();
+                if (read != m_readindex.load(std::memory_order_relaxed)) m_readindex.store(read, std::memory_order_release);
+            }
+
+            std::size_t GetWriteAvailable() const
+            {
+                uint64_t write = m_writeindex.load(std::memory_order_acquire);
+                return m_capacity - static_cast<std::size_t>(write - m_readindex.load(std::memory_order_acquire));
+            }
+
+            /// Total values ever written, a flush does not rewind it.
+            uint64_t GetWritePosition() const
+            {
+                return m_writeindex.load(std::memory_order_acquire);
+            }
+
+            /// Index of the next value the consumer will see, skipped values count as consumed.
+            uint64_t GetReadPosition() const
+            {
+                return std::max(m_readindex.load(std::memory_order_acquire), m_flushindex.load(std::memory_order_acquire));
+            }
+
+            void Flush()
+            {
+                m_flushrequested.store(false, std::memory_order_relaxed);
+                m_flushindex.store(m_writeindex.load(std::memory_order_acquire), std::memory_order_release);
+            }
+
+            /// Any thread, the producer drops everything written up to its next ApplyFlush().
+            void RequestFlush()
+            {
+                m_flushrequested.store(true, std::memory_order_release);
+            }
+
+            /// Producer side, true when a requested flush was carried out.
+            bool ApplyFlush()
+            {
+                if (!m_flushrequested.exchange(false, std::memory_order_acq_rel)) return false;
+                m_flushindex.store(m_writeindex.load(std::memory_order_relaxed), std::memory_order_release);
+                return true;
+            }
+        };
+    }
+}
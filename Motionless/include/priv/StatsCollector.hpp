@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "include/PlaybackStats.hpp"
+#include "include/NonCopyable.h"
+
+namespace mt
+{
+    namespace priv
+    {
+        /// Counters are only ever touched with relaxed atomics, they are statistics and never
+        /// used to order anything, so leaving collection on costs a handful of uncontended adds.
+        inline void IncrementStat(std::atomic<uint64_t>& Counter, uint64_t Amount = 1)
+        {
+            Counter.fetch_add(Amount, std::memory_order_relaxed);
+        }
+
+        inline void RaiseHighWater(std::atomic<std::size_t>& HighWater, std::size_t Value)
+        {
+            std::size_t current = HighWater.load(std::memory_order_relaxed);
+            while (Value > current && !HighWater.compare_exchange_weak(current, Value, std::memory_order_relaxed));
+        }
+
+        class AtomicHistogram : private mt::NonCopyable
+        {
+        private:
+            std::array<std::atomic<uint64_t>, TimeHistogram::BucketCount> m_buckets;
+            std::atomic<uint64_t> m_count;
+            std::atomic<uint64_t> m_total;
+            std::atomic<uint64_t> m_max;
+
+        public:
+            AtomicHistogram();
+            void Record(std::chrono::steady_clock::duration Duration);
+            const TimeHistogram Snapshot() const;
+            void Reset();
+        };
+
+        class StatsCollector : private mt::NonCopyable
+        {
+        public:
+            std::atomic<uint64_t> decodedvideoframes;
+            std::atomic<uint64_t> decodedaudioframes;
+            std::atomic<uint64_t> convertedframes;
+            std::atomic<uint64_t> presentedframes;
+            std::atomic<uint64_t> droppedframes;
+            std::atomic<uint64_t> bytesread;
+            std::atomic<uint64_t> seekcount;
+            std::atomic<std::size_t> queuedepthhighwater;
+            std::atomic<long long> audiodrift;
+            std::atomic<uint64_t> audiodriftcorrections;
+            std::atomic<uint64_t> audioresyncs;
+            std::atomic<uint64_t> framecachehits;
+            std::atomic<uint64_t> framecachemisses;
+            std::atomic<uint64_t> loopwraps;
+            AtomicHistogram readtime;
+            AtomicHistogram decodetime;
+            AtomicHistogram converttime;
+            AtomicHistogram decodecopytime;
+            AtomicHistogram seeklatency;
+
+            StatsCollector();
+            void Fill(DataSourceStats& Stats) const;
+            void Reset();
+        };
+    }
+}
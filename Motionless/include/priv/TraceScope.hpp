@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+#ifdef MOTIONLESS_TRACING
+
+#define MT_TRACE_CONCAT_IMPL(A, B) A##B
+#define MT_TRACE_CONCAT(A, B) MT_TRACE_CONCAT_IMPL(A, B)
+#define MT_TRACE_SCOPE(Name) ::mt::priv::TraceScope MT_TRACE_CONCAT(tracescope, __LINE__)(Name)
+#define MT_TRACE_EVENT(Name, Start, End) do { if (::mt::priv::g_tracerecording.load(std::memory_order_relaxed)) ::mt::priv::TraceRecord(Name, Start, End); } while (false)
+#define MT_TRACE_THREAD_NAME(Name) ::mt::priv::TraceSetThreadName(Name)
+
+namespace mt
+{
+    namespace priv
+    {
+        extern std::atomic<bool> g_tracerecording;
+
+        void TraceRecord(const char* Name, std::chrono::steady_clock::time_point Start, std::chrono::steady_clock::time_point End);
+        void TraceSetThreadName(const char* Name);
+
+        /// Names must be string literals, only the pointer is stored.
+        class TraceScope
+        {
+        private:
+            const char* m_name;
+            bool m_recording;
+            std::chrono::steady_clock::time_point m_start;
+
+        public:
+            TraceScope(const char* Name) :
+                m_name(Name),
+                m_recording(g_tracerecording.load(std::memory_order_relaxed))
+            {
+                if (m_recording) m_start = std::chrono::steady_clock::now();
+            }
+
+            ~TraceScope()
+            {
+                if (m_recording) TraceRecord(m_name, m_start, std::chrono::steady_clock::now());
+            }
+
+            TraceScope(const TraceScope&) = delete;
+            TraceScope& operator=(const TraceScope&) = delete;
+        };
+    }
+}
+
+#else
+
+#define MT_TRACE_SCOPE(Name)
+#define MT_TRACE_EVENT(Name, Start, End)
+#define MT_TRACE_THREAD_NAME(Name)
+
+#endif
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+
+#include "include/Executor.hpp"
+#include "include/State.hpp"
+#include "include/priv/ReadyNotifier.hpp"
+#include "include/priv/VideoPacket.hpp"
+#include "include/NonCopyable.h"
+
+namespace mt
+{
+    class DataSource;
+    class VideoPlayback;
+    class FrameReader;
+    class Playlist;
+
+    namespace priv
+    {
+        /// The part of a VideoPlayback the source queues frames into and updates.  Shared between
+        /// the playback and every list of consumers the source published it in, so the playback
+        /// can go away while the render or decode thread is still walking an older list and the
+        /// consumer is freed once the last of them lets go.
+        class VideoConsumer : private mt::NonCopyable
+        {
+            friend class mt::DataSource;
+            friend class mt::VideoPlayback;
+            friend class mt::FrameReader;
+            friend class mt::Playlist;
+
+        public:
+            typedef std::function<void(VideoPacketPtr)> FrameCallback;
+
+        private:
+            DataSource* m_datasource;
+            std::mutex m_protectionlock;
+            std::queue<VideoPacketPtr> m_queuedvideopackets;
+            std::condition_variable m_framequeued;
+            std::atomic<bool> m_offline;
+            std::mutex m_asynclock;
+            FrameCallback m_pendingcallback;
+            Executor m_pendingexecutor;
+            std::chrono::microseconds m_elapsed;
+            std::chrono::microseconds m_frametime;
+            int m_framejump;
+            std::chrono::microseconds m_nextdue;
+            std::chrono::microseconds m_lastpts;
+            unsigned int m_playedframecount;
+            std::atomic<unsigned int> m_deadlinemisscount;
+            std::atomic<uint64_t> m_presentedframecount;
+            std::atomic<uint64_t> m_droppedframecount;
+            std::atomic<std::size_t> m_queuehighwater;
+            ReadyNotifier m_ready;
+            VideoPacketPtr m_lastpacket;
+
+            void SourceReloaded();
+            void StateChanged(State PreviousState, State NewState);
+            void Update(std::chrono::microseconds DeltaTime);
+            void UpdateToClock(std::chrono::microseconds Clock, bool Reverse);
+            bool StepPast(std::chrono::microseconds Clock, bool Reverse);
+            void Present(const VideoPacketPtr& Packet);
+            void ResetStats();
+            bool TakeFrame(VideoPacketPtr& Frame);
+            std::function<void()> TakePending();
+            static std::function<void()> MakeTask(FrameCallback Callback, Executor Executor, VideoPacketPtr Frame);
+
+        public:
+            VideoConsumer(DataSource& DataSource);
+        };
+
+        typedef std::shared_ptr<VideoConsumer> VideoConsumerPtr;
+    }
+}
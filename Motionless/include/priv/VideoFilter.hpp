@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <functional>
+
+#include "include/NonCopyable.h"
+
+extern "C"
+{
+#include <libavfilter/avfilter.h>
+#include <libavfilter/buffersink.h>
+#include <libavfilter/buffersrc.h>
+#include <libavutil/frame.h>
+}
+
+namespace mt
+{
+    namespace priv
+    {
+        /// Runs decoded video through a libavfilter graph given in the usual filter syntax
+        /// ("yadif,crop=640:360,hflip").  The sink only accepts RGBA, so the conversion is the
+        /// graph's own scale filter at the end of the chain rather than a second pass, and the
+        /// filters run on the graph's slice threads.
+        class VideoFilter : private mt::NonCopyable
+        {
+        private:
+            AVFilterGraph* m_graph;
+            AVFilterContext* m_source;
+            AVFilterContext* m_sink;
+            AVFrame* m_output;
+            std::string m_description;
+            int m_width;
+            int m_height;
+            AVPixelFormat m_format;
+            AVRational m_timebase;
+            AVRational m_aspectratio;
+
+            bool CreateGraph();
+
+        public:
+            typedef std::function<void(AVFrame* Frame)> OutputCallback;
+
+            VideoFilter();
+            ~VideoFilter();
+            /// Builds the graph for frames of the given layout, an empty description destroys it.
+            bool Create(const std::string& Description, int Width, int Height, AVPixelFormat Format, AVRational TimeBase, AVRational AspectRatio);
+            void Destroy();
+            /// Builds the graph again, dropping frames that filters looking at their neighbours still hold.
+            bool Flush();
+            const std::string& GetDescription() const;
+            bool IsActive() const;
+            int GetOutputWidth() const;
+            int GetOutputHeight() const;
+            AVRational GetOutputTimeBase() const;
+            /// Feeds Frame in and hands every RGBA frame that comes out to Output.
+            bool Process(AVFrame* Frame, const OutputCallback& Output);
+        };
+    }
+}
@@ -4,6 +4,10 @@
 #include <cstddef>
 #include <memory>
 #include <cstring>
+#include <chrono>
+
+#include "include/FrameSink.hpp"
+#include "include/priv/MemoryAccount.hpp"
 
 extern "C"
 {
@@ -16,18 +20,44 @@ extern "C"
 
 namespace mt
 {
+    class DataSource;
+
     namespace priv
     {
         class VideoPacket
         {
+            friend class mt::DataSource;
+
         private:
+            uint8_t* m_allocation;
             uint8_t* m_rgbabuffer;
+            int m_alignment;
+            MemoryAccountPtr m_account;
+            FrameSinkPtr m_sink;
+            std::shared_ptr<VideoPacket> m_shared;
+
+            void Allocate();
         public:
-            VideoPacket(uint8_t* RGBABufferSource, int Width, int Height);
+            /// The pixel data is charged to Account, if given, for as long as the packet lives.
+            /// SourceStride is the byte distance between rows of the source, 0 for tightly packed.
+            VideoPacket(uint8_t* RGBABufferSource, int Width, int Height, std::chrono::microseconds Pts = std::chrono::microseconds(0), MemoryAccountPtr Account = nullptr, int SourceStride = 0);
+            /// An unfilled packet for the decoder to convert into, in memory from Sink when it has some.
+            /// Memory from a sink is the caller's and not charged to Account.  Rows start at multiples
+            /// of Alignment bytes, a power of two.
+            VideoPacket(int Width, int Height, std::chrono::microseconds Pts, MemoryAccountPtr Account, FrameSinkPtr Sink, int Alignment = 1);
+            /// The pixels of Source under another timestamp, without copying them.  Source is kept
+            /// alive with them and neither may be written afterwards.
+            VideoPacket(const std::shared_ptr<VideoPacket>& Source, std::chrono::microseconds Pts);
             ~VideoPacket();
 			VideoPacket(const VideoPacket& other);
             const uint8_t* GetRGBABuffer();
 			int width, height;
+            /// Byte distance between rows of GetRGBABuffer(), width * 4 rounded up to the source's row
+            /// alignment or whatever a frame sink asked for.
+            int stride;
+            static int GetAlignedStride(int Width, int Alignment);
+            /// Presentation time relative to the start of the file.
+            std::chrono::microseconds pts;
         };
 
         typedef std::shared_ptr<mt::priv::VideoPacket> VideoPacketPtr;
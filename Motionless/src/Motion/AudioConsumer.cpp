@@ -0,0 +1,197 @@
+#pragma once
+
+#include "include/DataSource.hpp"
+#include "include/priv/AudioConsumer.hpp"
+
+#include <algorithm>
+
+#define AUDIO_RING_SAMPLES 262144
+
+namespace mt
+{
+    namespace priv
+    {
+        AudioConsumer::AudioConsumer(DataSource& DataSource, mt::AudioPlayback& Playback, std::chrono::microseconds OffsetCorrection) :
+            m_playback(&Playback),
+            m_channelcount(0),
+            m_targetbufferedframes(0),
+            m_offsetcorrection(OffsetCorrection),
+            m_datasource(&DataSource),
+            m_protectionlock(),
+            m_samples(AUDIO_RING_SAMPLES),
+            m_overflow(),
+            m_memory(DataSource.m_memory),
+            m_playing(false),
+            m_volume(1.f),
+            m_consumedframecount(0),
+            m_underruncount(0),
+            m_clocklock(),
+            m_clockanchors()
+        {
+            m_memory->Charge(MemoryCategory::Audio, m_samples.GetCapacity() * sizeof(int16_t));
+            SourceReloaded();
+        }
+
+        AudioConsumer::~AudioConsumer()
+        {
+            m_memory->Release(MemoryCategory::Audio, m_samples.GetCapacity() * sizeof(int16_t));
+        }
+
+        std::size_t AudioConsumer::ReadSamples(int16_t* Destination, std::size_t FrameCount)
+        {
+            int channelcount = std::max(m_channelcount.load(), 1);
+            std::size_t framesread = 0;
+            // flushed samples hold their slots until the device side lets go of them, paused or not
+            m_samples.SkipFlushed();
+            if (m_playing)
+            {
+                framesread = m_samples.Read(Destination, FrameCount * channelcount) / channelcount;
+                m_consumedframecount.fetch_add(framesread, std::memory_order_relaxed);
+                if (framesread < FrameCount && m_datasource && !m_datasource->m_playingtoeof)
+                {
+                    m_underruncount.fetch_add(1, std::memory_order_relaxed);
+                }
+                float volume = m_volume.load(std::memory_order_relaxed);
+                if (volume != 1.f)
+                {
+                    for (std::size_t i = 0; i < framesread * channelcount; i++)
+                    {
+                        Destination[i] = static_cast<int16_t>(std::max(-32768.f, std::min(32767.f, Destination[i] * volume)));
+                    }
+                }
+            }
+            std::fill(Destination + framesread * channelcount, Destination + FrameCount * channelcount, static_cast<int16_t>(0));
+            return framesread;
+        }
+
+        bool AudioConsumer::IsBufferFull()
+        {
+            // the source sizes the queue, the ring capacity caps it
+            std::size_t target = std::min<std::size_t>(m_targetbufferedframes, m_datasource ? m_datasource->m_audioqueueframes.load() : 0);
+            return GetBufferedFrameCount() + m_overflow.size() / std::max(m_channelcount.load(), 1) >= target;
+        }
+
+        void AudioConsumer::Flush()
+        {
+            // the decoder is stopped, anything else goes through RequestFlush()
+            m_samples.Flush();
+            m_overflow.clear();
+            std::lock_guard<std::mutex> lock(m_clocklock);
+            m_clockanchors.clear();
+        }
+
+        void AudioConsumer::WriteSamples(const int16_t* Samples, std::size_t FrameCount, std::chrono::microseconds Pts, float Tempo)
+        {
+            // the first write after a flush pins the timestamp of that ring position, the decoder keeps
+            // the sample count in step with the timestamps so everything after follows from it.  A tempo
+            // change starts a new anchor where the previous one leaves off so the clock stays continuous.
+            WriteOverflow();
+            {
+                std::lock_guard<std::mutex> lock(m_clocklock);
+                uint64_t position = m_samples.GetWritePosition() + m_overflow.size();
+                if (m_clockanchors.empty())
+                {
+                    m_clockanchors.push_back(ClockAnchor{ position, Pts, Tempo });
+                }
+                else if (m_clockanchors.back().tempo != Tempo)
+                {
+                    m_clockanchors.push_back(ClockAnchor{ position, GetAnchorTime(m_clockanchors.back(), position), Tempo });
+                }
+            }
+            // samples that do not fit wait behind the ones already waiting, none are dropped
+            std::size_t count = FrameCount * std::max(m_channelcount.load(), 1);
+            std::size_t written = m_overflow.empty() ? m_samples.Write(Samples, count) : 0;
+            m_overflow.insert(m_overflow.end(), Samples + written, Samples + count);
+        }
+
+        void AudioConsumer::WriteOverflow()
+        {
+            // decode thread only, a flush requested from another thread is carried out here where nothing is being written
+            if (m_samples.ApplyFlush())
+            {
+                m_overflow.clear();
+                std::lock_guard<std::mutex> lock(m_clocklock);
+                m_clockanchors.clear();
+            }
+            if (m_overflow.empty()) return;
+            std::size_t written = m_samples.Write(m_overflow.data(), m_overflow.size());
+            m_overflow.erase(m_overflow.begin(), m_overflow.begin() + written);
+        }
+
+        std::chrono::microseconds AudioConsumer::GetAnchorTime(const ClockAnchor& Anchor, uint64_t Position)
+        {
+            int samplerate = GetSampleRate();
+            if (samplerate <= 0 || Position < Anchor.position) return Anchor.pts;
+            uint64_t frames = (Position - Anchor.position) / std::max(m_channelcount.load(), 1);
+            return Anchor.pts + std::chrono::microseconds(static_cast<long long>(frames * 1000000.0 * Anchor.tempo / samplerate));
+        }
+
+        void AudioConsumer::SourceReloaded()
+        {
+            if (m_datasource->HasAudio())
+            {
+                m_channelcount = m_datasource->GetAudioChannelCount();
+                // never queue more than half the ring, whatever duration the source asks for
+                m_targetbufferedframes = m_samples.GetCapacity() / 2 / std::max(m_channelcount.load(), 1);
+                StateChanged(m_datasource->GetState(), m_datasource->GetState());
+            }
+        }
+
+        void AudioConsumer::StateChanged(State, State NewState)
+        {
+            m_playing = NewState == State::Playing;
+            if (NewState == State::Stopped)
+            {
+                // the decoder may still be writing, it drops the samples itself.  The clock stops right away.
+                m_samples.RequestFlush();
+                std::lock_guard<std::mutex> lock(m_clocklock);
+                m_clockanchors.clear();
+            }
+        }
+
+        const int AudioConsumer::GetSampleRate()
+        {
+            if (!m_datasource) return -1;
+            return m_datasource->GetAudioSampleRate();
+        }
+
+        const std::size_t AudioConsumer::GetBufferedFrameCount()
+        {
+            return m_samples.GetReadAvailable() / std::max(m_channelcount.load(), 1);
+        }
+
+        const bool AudioConsumer::HasClock()
+        {
+            std::lock_guard<std::mutex> lock(m_clocklock);
+            return !m_clockanchors.empty();
+        }
+
+        const std::chrono::microseconds AudioConsumer::GetClock()
+        {
+            auto offsetcorrection = GetOffsetCorrection();
+            std::lock_guard<std::mutex> lock(m_clocklock);
+            if (m_clockanchors.empty()) return std::chrono::microseconds(0);
+            uint64_t position = m_samples.GetReadPosition();
+            // anchors the device has played past are done with
+            while (m_clockanchors.size() > 1 && m_clockanchors[1].position <= position)
+            {
+                m_clockanchors.pop_front();
+            }
+            const ClockAnchor& anchor = m_clockanchors.front();
+            auto clock = GetAnchorTime(anchor, position) - std::chrono::microseconds(static_cast<long long>(offsetcorrection.count() * anchor.tempo));
+            return std::max(clock, anchor.pts);
+        }
+
+        const std::chrono::microseconds AudioConsumer::GetOffsetCorrection()
+        {
+            std::lock_guard<std::mutex> lock(m_protectionlock);
+            return m_offsetcorrection;
+        }
+
+        void AudioConsumer::SetOffsetCorrection(std::chrono::microseconds OffsetCorrection)
+        {
+            std::lock_guard<std::mutex> lock(m_protectionlock);
+            m_offsetcorrection = OffsetCorrection;
+        }
+    }
+}
@@ -5,205 +5,75 @@
 
 namespace mt
 {
-
-	/// Most of this file is unuseable at the moment.  I have no need of audio for my application.
-	/// If you require it, you will need to test this code out.
-
     AudioPlayback::AudioPlayback(DataSource& DataSource, std::chrono::microseconds AudioOffsetCorrection) :
-        //m_audioplayrate(sf::Time::Zero),
-		m_audiorate(0),
-        m_channelcount(0),
-        //m_audioposition(),
-		m_audioposition(0),
-        //m_offsetcorrection(AudioOffsetCorrection),
-		m_offsetcorrection(AudioOffsetCorrection),
-        //m_updateclock(),
-        m_datasource(&DataSource),
-        m_protectionlock(),
-        m_queuedaudiopackets(),
-        m_activepacket(nullptr)
+        m_consumer(std::make_shared<priv::AudioConsumer>(DataSource, *this, AudioOffsetCorrection))
     {
-        SourceReloaded();
-		std::lock_guard<std::mutex> lock(m_datasource->m_playbacklock);
-        m_datasource->m_audioplaybacks.push_back(this);
+        DataSource.AttachPlayback(m_consumer);
     }
 
     AudioPlayback::~AudioPlayback()
     {
-        if (m_datasource)
-        {
-			std::lock_guard<std::mutex> lock(m_datasource->m_playbacklock);
-            for (auto& audioplayback : m_datasource->m_audioplaybacks)
-            {
-                if (audioplayback == this)
-                {
-                    std::swap(audioplayback, m_datasource->m_audioplaybacks.back());
-                    m_datasource->m_audioplaybacks.pop_back();
-                    break;
-                }
-            }
-            m_datasource = nullptr;
-        }
-        //stop();
+        // also drops it as the master clock, the decode thread may still be writing through an older list
+        if (m_consumer->m_datasource) m_consumer->m_datasource->DetachPlayback(m_consumer);
     }
 
-    /*bool AudioPlayback::onGetData(Chunk& data)
+    std::size_t AudioPlayback::ReadSamples(int16_t* Destination, std::size_t FrameCount)
     {
-        bool hasdata = WaitForData();
-		std::lock_guard<std::mutex> lock(m_protectionlock);
-        m_activepacket = nullptr;
-        if (m_datasource && hasdata)
-        {
-            if (m_offsetcorrection != sf::Time::Zero && m_audioposition >= m_offsetcorrection)
-            {
-                // add samples
-                std::size_t samplecount = static_cast<std::size_t>(std::floor(m_audioposition.asSeconds() * m_audioplayrate.asSeconds() * m_channelcount));
-                std::vector<int16_t> newsamples;
-                newsamples.resize(samplecount);
-                m_activepacket = std::make_shared<priv::AudioPacket>(&newsamples[0], samplecount / m_channelcount, m_channelcount);
-                m_audioposition -= sf::seconds(m_activepacket->GetSamplesBufferLength() / m_audioplayrate.asSeconds() / m_channelcount);
+        return m_consumer->ReadSamples(Destination, FrameCount);
+    }
 
-            }
-            else if (m_offsetcorrection != sf::Time::Zero && m_audioposition < -m_offsetcorrection)
-            {
-                // skip samples
-                bool shouldSkip = true;
-                while (shouldSkip && hasdata)
-                {
-                    m_audioposition += sf::seconds(m_queuedaudiopackets.front()->GetSamplesBufferLength() / m_audioplayrate.asSeconds() / m_channelcount);
-                    m_queuedaudiopackets.pop();
-                    m_protectionlock.unlock(); // unlock to wait for data
-                    hasdata = WaitForData();
-                    m_protectionlock.lock(); // relock after waiting for data
-                    shouldSkip = m_audioposition <= -m_offsetcorrection;
-                }
-                if (hasdata)
-                {
-                    m_activepacket = m_queuedaudiopackets.front();
-                    m_queuedaudiopackets.pop();
-                    m_audioposition += sf::seconds(m_activepacket->GetSamplesBufferLength() / m_audioplayrate.asSeconds() / m_channelcount);
-                }
-            }
-            else
-            {
-                // continue as normal
-                if (m_queuedaudiopackets.size() > 0)
-                {
-                    m_activepacket = m_queuedaudiopackets.front();
-                    m_queuedaudiopackets.pop();
-                    m_audioposition += sf::seconds(m_activepacket->GetSamplesBufferLength() / m_audioplayrate.asSeconds() / m_channelcount);
-                }
-            }
-        }
-        if (m_activepacket)
-        {
-            data.samples = m_activepacket->GetSamplesBuffer();
-            data.sampleCount = m_activepacket->GetSamplesBufferLength();
-        }
-        return static_cast<bool>(m_activepacket);
-    }*/
+    const int AudioPlayback::GetChannelCount()
+    {
+        return m_consumer->m_channelcount;
+    }
 
-    void AudioPlayback::onSeek(std::chrono::microseconds timeOffset)
+    const int AudioPlayback::GetSampleRate()
     {
-        // nothing to do
+        return m_consumer->GetSampleRate();
     }
 
-    bool AudioPlayback::WaitForData()
+    const std::size_t AudioPlayback::GetBufferedFrameCount()
     {
-        bool hasdata = false;
-        while (!hasdata && m_datasource && !m_datasource->m_eofreached)
-        {
-            {
-				std::lock_guard<std::mutex> lock(m_protectionlock);
-                hasdata = m_queuedaudiopackets.size() > 0;
-                if (hasdata)
-                {
-					auto now = std::chrono::steady_clock::now();
-					auto delta = now - mStart;
-					mStart = now;
-					auto duration = std::chrono::duration_cast<std::chrono::microseconds>(delta);
-					m_audioposition -= duration;
-					//m_audioposition -= m_updateclock.restart() * getPitch();
-                }
-            }
-            if (!hasdata) std::this_thread::sleep_for(std::chrono::milliseconds(3));
-        }
+        return m_consumer->GetBufferedFrameCount();
+    }
 
-        if (!hasdata)
-        {
-			std::lock_guard<std::mutex> lock(m_protectionlock);
-			auto now = std::chrono::steady_clock::now();
-			auto delta = now - mStart;
-			mStart = now;
-			auto duration = std::chrono::duration_cast<std::chrono::microseconds>(delta);
-			m_audioposition -= duration;
-            //m_audioposition -= m_updateclock.restart() * getPitch();
-        }
+    const uint64_t AudioPlayback::GetConsumedFrameCount()
+    {
+        return m_consumer->m_consumedframecount.load(std::memory_order_relaxed);
+    }
 
-        return hasdata;
+    const uint64_t AudioPlayback::GetUnderrunCount()
+    {
+        return m_consumer->m_underruncount.load(std::memory_order_relaxed);
     }
 
-    void AudioPlayback::SourceReloaded()
+    const bool AudioPlayback::HasClock()
     {
-        if (m_datasource->HasAudio())
-        {
-			m_audiorate = std::chrono::microseconds(m_datasource->GetAudioSampleRate() / 1000000);
-            //m_audioplayrate = sf::seconds(static_cast<float>(m_datasource->GetAudioSampleRate()));
-            m_channelcount = m_datasource->GetAudioChannelCount();
-            //initialize(m_channelcount, m_datasource->GetAudioSampleRate());
-            //setPitch(m_datasource->GetPlaybackSpeed());
-            StateChanged(m_datasource->GetState(), m_datasource->GetState());
-        }
+        return m_consumer->HasClock();
     }
 
-    void AudioPlayback::StateChanged(State PreviousState, State NewState)
+    const std::chrono::microseconds AudioPlayback::GetClock()
     {
-        if (NewState == State::Playing && m_datasource->HasAudio())
-        {
-            //play();
-			std::lock_guard<std::mutex> lock(m_protectionlock);
-			mStart = std::chrono::steady_clock::now();
-            //m_updateclock.restart();
-        }
-        else if (NewState == State::Paused && m_datasource->HasAudio())
-        {
-            //pause();
-        }
-        else if (NewState == State::Stopped)
-        {
-            //stop();
-			std::lock_guard<std::mutex> lock(m_protectionlock);
-			m_audioposition = std::chrono::microseconds(0);
-            //m_audioposition = sf::Time::Zero;
-            while (m_queuedaudiopackets.size() > 0)
-            {
-                m_queuedaudiopackets.pop();
-            }
-        }
+        return m_consumer->GetClock();
     }
 
     const float AudioPlayback::GetVolume()
     {
-        //return getVolume();
-		return 0.f;
+        return m_consumer->m_volume;
     }
 
     void AudioPlayback::SetVolume(float Volume)
     {
-        //setVolume(Volume);
+        m_consumer->m_volume = Volume;
     }
 
     const std::chrono::microseconds AudioPlayback::GetOffsetCorrection()
     {
-		std::lock_guard<std::mutex> lock(m_protectionlock);
-		return m_offsetcorrection;
-        //return m_offsetcorrection;
+        return m_consumer->GetOffsetCorrection();
     }
 
     void AudioPlayback::SetOffsetCorrection(std::chrono::microseconds OffsetCorrection)
     {
-		std::lock_guard<std::mutex> lock(m_protectionlock);
-		m_offsetcorrection = OffsetCorrection;
-        //m_offsetcorrection = OffsetCorrection;
+        m_consumer->SetOffsetCorrection(OffsetCorrection);
     }
-}
\ No newline at end of file
+}
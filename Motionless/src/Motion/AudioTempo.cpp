@@ -0,0 +1,135 @@
+#pragma once
+
+#include "include/priv/AudioTempo.hpp"
+
+#include <iostream>
+#include <string>
+
+extern "C"
+{
+#include <libavutil/channel_layout.h>
+#include <libavutil/opt.h>
+}
+
+#define ATEMPO_MIN 0.5f
+#define ATEMPO_MAX 2.0f
+
+namespace mt
+{
+    namespace priv
+    {
+        AudioTempo::AudioTempo() :
+            m_graph(nullptr),
+            m_source(nullptr),
+            m_sink(nullptr),
+            m_input(av_frame_alloc()),
+            m_output(av_frame_alloc()),
+            m_tempo(1.f),
+            m_samplerate(0),
+            m_channellayout(0),
+            m_nextpts(0)
+        { }
+
+        AudioTempo::~AudioTempo()
+        {
+            Reset();
+            av_frame_free(&m_input);
+            av_frame_free(&m_output);
+        }
+
+        bool AudioTempo::Configure(int SampleRate, uint64_t ChannelLayout, float Tempo)
+        {
+            if (m_tempo == Tempo && m_samplerate == SampleRate && m_channellayout == ChannelLayout) return true;
+            Reset();
+            m_samplerate = SampleRate;
+            m_channellayout = ChannelLayout;
+            m_tempo = Tempo;
+            if (Tempo == 1.f) return true;
+            if (!CreateGraph())
+            {
+                std::cout << "Motion: Failed to create audio tempo filter" << std::endl;
+                // stay at this tempo passing samples through rather than retrying every chunk
+                Reset();
+                m_tempo = Tempo;
+                return false;
+            }
+            return true;
+        }
+
+        bool AudioTempo::CreateGraph()
+        {
+            avfilter_register_all();
+            m_graph = avfilter_graph_alloc();
+            if (!m_graph) return false;
+            std::string sourceargs = "time_base=1/" + std::to_string(m_samplerate) + ":sample_rate=" + std::to_string(m_samplerate) +
+                ":sample_fmt=s16:channel_layout=" + std::to_string(m_channellayout);
+            if (avfilter_graph_create_filter(&m_source, avfilter_get_by_name("abuffer"), "in", sourceargs.c_str(), nullptr, m_graph) < 0) return false;
+            if (avfilter_graph_create_filter(&m_sink, avfilter_get_by_name("abuffersink"), "out", nullptr, nullptr, m_graph) < 0) return false;
+            const AVSampleFormat sampleformats[] = { AV_SAMPLE_FMT_S16, AV_SAMPLE_FMT_NONE };
+            if (av_opt_set_int_list(m_sink, "sample_fmts", sampleformats, AV_SAMPLE_FMT_NONE, AV_OPT_SEARCH_CHILDREN) < 0) return false;
+            AVFilterContext* previous = m_source;
+            float remaining = m_tempo;
+            int index = 0;
+            while (remaining != 1.f)
+            {
+                float step = remaining > ATEMPO_MAX ? ATEMPO_MAX : (remaining < ATEMPO_MIN ? ATEMPO_MIN : remaining);
+                remaining /= step;
+                if (remaining > 0.999f && remaining < 1.001f) remaining = 1.f;
+                AVFilterContext* atempo = nullptr;
+                std::string name = "atempo" + std::to_string(index++);
+                if (avfilter_graph_create_filter(&atempo, avfilter_get_by_name("atempo"), name.c_str(), ("tempo=" + std::to_string(step)).c_str(), nullptr, m_graph) < 0) return false;
+                if (avfilter_link(previous, 0, atempo, 0) < 0) return false;
+                previous = atempo;
+            }
+            if (avfilter_link(previous, 0, m_sink, 0) < 0) return false;
+            return avfilter_graph_config(m_graph, nullptr) >= 0;
+        }
+
+        void AudioTempo::Reset()
+        {
+            if (m_graph) avfilter_graph_free(&m_graph);
+            m_graph = nullptr;
+            m_source = nullptr;
+            m_sink = nullptr;
+            m_tempo = 1.f;
+            m_nextpts = 0;
+        }
+
+        float AudioTempo::GetTempo() const
+        {
+            return m_tempo;
+        }
+
+        bool AudioTempo::IsActive() const
+        {
+            return m_graph != nullptr;
+        }
+
+        bool AudioTempo::Process(const int16_t* Samples, int FrameCount, const OutputCallback& Output)
+        {
+            if (!m_graph) return false;
+            // the source copies out of a frame that does not own its data, so the decoder buffer can be reused
+            int channelcount = av_get_channel_layout_nb_channels(m_channellayout);
+            m_input->nb_samples = FrameCount;
+            m_input->format = AV_SAMPLE_FMT_S16;
+            m_input->sample_rate = m_samplerate;
+            m_input->channel_layout = m_channellayout;
+            av_frame_set_channels(m_input, channelcount);
+            m_input->pts = m_nextpts;
+            m_input->data[0] = const_cast<uint8_t*>(reinterpret_cast<const uint8_t*>(Samples));
+            m_input->linesize[0] = FrameCount * channelcount * static_cast<int>(sizeof(int16_t));
+            m_input->extended_data = m_input->data;
+            m_nextpts += FrameCount;
+            int result = av_buffersrc_write_frame(m_source, m_input);
+            m_input->data[0] = nullptr;
+            m_input->extended_data = nullptr;
+            if (result < 0) return false;
+            while (av_buffersink_get_frame(m_sink, m_output) >= 0)
+            {
+                Output(reinterpret_cast<const int16_t*>(m_output->data[0]), m_output->nb_samples);
+                av_frame_unref(m_output);
+            }
+            return true;
+        }
+    }
+}
@@ -1,14 +1,65 @@
 #pragma once
 
 #include "../../include/DataSource.hpp"
+#include "../../include/FrameReader.hpp"
+#include "../../include/priv/TraceScope.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
 #include <thread>
 
 #define MAX_AUDIO_SAMPLES 192000
-#define PACKET_QUEUE_AMOUNT 5
+#define QUEUE_MIN_FRAMES 2
+#define QUEUE_MAX_FRAMES 120
+#define QUEUE_MAX_BYTES (128 * 1024 * 1024)
+#define QUEUE_MIN_DURATION_MS 200
+#define QUEUE_MAX_DURATION_MS 2000
+#define QUEUE_JITTER_WINDOW 32.0
+#define QUEUE_JITTER_FACTOR 4.0
+#define QUEUE_MAX_PARKED_BYTES (16 * 1024 * 1024)
+#define AUDIO_DRIFT_THRESHOLD_US 2000
+#define AUDIO_RESYNC_THRESHOLD_US 500000
+#define AUDIO_MAX_COMPENSATION_PERCENT 10
+#define MIN_PLAYBACK_SPEED 0.25f
+#define MAX_PLAYBACK_SPEED 16.f
+#define SPEED_SKIP_NONREF 2.f
+#define SPEED_SKIP_NONKEY 8.f
+#define NO_DEADLINE std::numeric_limits<long long>::max()
+#define LOW_PRIORITY_SLICE_FRAMES 2
+#define REVERSE_CACHE_BYTES (256 * 1024 * 1024)
+#define STEP_TIMEOUT_MS 2000
+#define STREAM_FIRST -2
+#define MAX_ROW_ALIGNMENT 4096
 
 namespace mt
 {
+    QueueLimits::QueueLimits() :
+        minframes(QUEUE_MIN_FRAMES),
+        maxframes(QUEUE_MAX_FRAMES),
+        maxbytes(QUEUE_MAX_BYTES),
+        minduration(std::chrono::milliseconds(QUEUE_MIN_DURATION_MS)),
+        maxduration(std::chrono::milliseconds(QUEUE_MAX_DURATION_MS)),
+        maxparkedbytes(QUEUE_MAX_PARKED_BYTES)
+    { }
+
+    StreamInfo::StreamInfo() :
+        index(-1),
+        type(StreamType::Other),
+        codec(),
+        language(),
+        title(),
+        isdefault(false),
+        selected(false),
+        width(0),
+        height(0),
+        samplerate(0),
+        channelcount(0),
+        duration(0)
+    { }
+
     DataSource::DataSource() :
+        m_filename(),
         m_videostreamid(-1),
         m_audiostreamid(-1),
 		m_playingoffset(),
@@ -21,40 +72,113 @@ namespace mt
         m_videocodec(nullptr),
         m_audiocodec(nullptr),
         m_videorawframe(nullptr),
-        m_videorgbaframe(nullptr),
         m_audiorawbuffer(nullptr),
         m_videorawbuffer(nullptr),
-        m_videorgbabuffer(nullptr),
+        m_videorawbuffersize(0),
         m_audiopcmbuffer(nullptr),
         m_videoswcontext(nullptr),
+        m_regionlock(),
+        m_region(),
+        m_convertregion(),
+        m_sinklock(),
+        m_framesink(),
+        m_rowalignment(1),
         m_audioswcontext(nullptr),
         m_state(State::Stopped),
+        m_decodemode(DecodeMode::DedicatedThread),
         m_decodethread(nullptr),
         m_shouldthreadrun(false),
+        m_taskstate(0),
+        m_priority(DecodePriority::Normal),
+        m_nextdeadline(NO_DEADLINE),
+        m_schedulerpasses(0),
+        m_deadlinemisscount(0),
+        m_stats(),
+        m_lastreadposition(-1),
+        m_seekstart(),
+        m_seekpending(false),
+        m_audiosynced(false),
+        m_audioanchorpts(0),
+        m_audiosamplecount(0),
+        m_nextvideopts(0),
+        m_audiotempo(),
+        m_videofilterdescription(),
+        m_videofilter(),
+        m_direction(PlaybackDirection::Forward),
+        m_reversecachelimit(REVERSE_CACHE_BYTES),
+        m_reverseframes(),
+        m_reverseupper(0),
+        m_reversedone(false),
+        m_framecache(),
+        m_looping(false),
+        m_loopstart(0),
+        m_loopend(0),
+        m_looplength(0),
+        m_loopshift(0),
+        m_loopresume(0),
+        m_loopskipuntil(std::chrono::microseconds::min()),
+        m_loopprefetch(),
+        m_loopfeed(0),
+        m_looppending(0),
+        m_loopcapturing(false),
+        m_loopprefetchpending(false),
+        m_loopwrap(false),
+        m_nextaudiopts(0),
+        m_seekdeferred(false),
+        m_offlinereaders(0),
+        m_wakelock(),
+        m_wakecondition(),
+        m_wakepending(false),
+        m_limitslock(),
+        m_queuelimits(),
+        m_producemean(0),
+        m_producevariance(0),
+        m_queuetarget(0),
+        m_videoqueuedepth(QUEUE_MIN_FRAMES),
+        m_audioqueueframes(0),
+        m_parkedvideo(),
+        m_parkedaudio(),
+        m_parkedcount(0),
+        m_parkedbytes(0),
+        m_demuxeof(false),
+        m_memory(MemoryGovernor::GetInstance().CreateAccount(this)),
         m_eofreached(false),
         m_playingtoeof(false),
+        m_slicevideoframes(0),
         m_playbacklock(),
-        m_videoplaybacks(),
-        m_audioplaybacks()
+        m_playbacks(std::make_shared<PlaybackList>()),
+        m_callbacklock(),
+        m_framereadycallback(),
+        m_framereadyexecutor(),
+        m_statechangedcallback(),
+        m_statechangedexecutor(),
+        m_ready()
     {
         av_register_all();
     }
 
     DataSource::~DataSource()
     {
+        {
+            // stopping on the way out is not reported, nothing may reach an executor after this
+            std::lock_guard<std::mutex> lock(m_callbacklock);
+            m_framereadycallback = nullptr;
+            m_statechangedcallback = nullptr;
+        }
         Cleanup();
+        m_memory->Detach();
         {
-			std::lock_guard<std::mutex> lock(m_playbacklock);
-            while (m_videoplaybacks.size() > 0)
+            std::lock_guard<std::mutex> lock(m_playbacklock);
+            PlaybackListPtr playbacks = GetPlaybacks();
+            for (auto& videoplayback : playbacks->video)
             {
-                m_videoplaybacks.back()->m_datasource = nullptr;
-                m_videoplaybacks.pop_back();
+                videoplayback->m_datasource = nullptr;
             }
-            while (m_audioplaybacks.size() > 0)
+            for (auto& audioplayback : playbacks->audio)
             {
-                m_audioplaybacks.back()->m_datasource = nullptr;
-                m_audioplaybacks.pop_back();
+                audioplayback->m_datasource = nullptr;
             }
+            PublishPlaybacks(std::unique_ptr<PlaybackList>(new PlaybackList()));
         }
     }
 
@@ -62,40 +186,43 @@ namespace mt
     {
         Stop();
         StopDecodeThread();
+        FlushParkedPackets();
         m_videostreamid = -1;
         m_audiostreamid = -1;
 		m_playingoffset = std::chrono::microseconds(0);
 		m_videosize = Vector2{ -1, -1 };
         m_audiochannelcount = -1;
+        m_nextdeadline = NO_DEADLINE;
         if (m_videocontext)
         {
             avcodec_close(m_videocontext);
             m_videocontext = nullptr;
         }
         m_videocodec = nullptr;
+        if (m_audiopcmbuffer)
+        {
+            m_memory->Release(MemoryCategory::Staging, av_samples_get_buffer_size(nullptr, m_audiocontext->channels, MAX_AUDIO_SAMPLES, AV_SAMPLE_FMT_S16, 0));
+            av_free(m_audiopcmbuffer);
+            m_audiopcmbuffer = nullptr;
+        }
         if (m_audiocontext)
         {
             avcodec_close(m_audiocontext);
             m_audiocontext = nullptr;
         }
         m_audiocodec = nullptr;
-        if (m_videorawframe) DestroyPictureFrame(m_videorawframe, m_videorawbuffer);
-        if (m_videorgbaframe) DestroyPictureFrame(m_videorgbaframe, m_videorgbabuffer);
+        if (m_videorawframe) DestroyPictureFrame(m_videorawframe, m_videorawbuffer, m_videorawbuffersize);
         if (m_audiorawbuffer)
         {
             av_frame_free(&m_audiorawbuffer);
             m_audiorawbuffer = nullptr;
         }
-        if (m_audiopcmbuffer)
-        {
-            av_free(m_audiopcmbuffer);
-            m_audiopcmbuffer = nullptr;
-        }
         if (m_videoswcontext)
         {
             sws_freeContext(m_videoswcontext);
             m_videoswcontext = nullptr;
         }
+        m_videofilter.Destroy();
         if (m_audioswcontext)
         {
             swr_free(&m_audioswcontext);
@@ -109,8 +236,14 @@ namespace mt
     }
 
     bool DataSource::LoadFromFile(const std::string& Filename, bool EnableVideo, bool EnableAudio)
+    {
+        return Load(Filename, EnableVideo ? STREAM_FIRST : -1, EnableAudio ? STREAM_FIRST : -1);
+    }
+
+    bool DataSource::Load(const std::string& Filename, int VideoStream, int AudioStream)
     {
         Cleanup();
+        m_filename = Filename;
         if (avformat_open_input(&m_formatcontext, Filename.c_str(), nullptr, nullptr) != 0)
         {
             std::cout << "Motion: Failed to open file: '" << Filename << "'" << std::endl;
@@ -126,10 +259,10 @@ namespace mt
             switch (m_formatcontext->streams[i]->codec->codec_type)
             {
                 case AVMEDIA_TYPE_VIDEO:
-                    if (m_videostreamid == -1 && EnableVideo) m_videostreamid = i;
+                    if (m_videostreamid == -1 && (VideoStream == STREAM_FIRST || VideoStream == static_cast<int>(i))) m_videostreamid = i;
                     break;
                 case AVMEDIA_TYPE_AUDIO:
-                    if (m_audiostreamid == -1 && EnableAudio) m_audiostreamid = i;
+                    if (m_audiostreamid == -1 && (AudioStream == STREAM_FIRST || AudioStream == static_cast<int>(i))) m_audiostreamid = i;
                     break;
                 default:
                     break;
@@ -161,9 +294,8 @@ namespace mt
                     else
                     {
                         m_videosize = Vector2(m_videocontext->width, m_videocontext->height);
-                        m_videorawframe = CreatePictureFrame(m_videocontext->pix_fmt, m_videosize.x, m_videosize.y, m_videorawbuffer);
-                        m_videorgbaframe = CreatePictureFrame(AVPixelFormat::AV_PIX_FMT_BGRA, m_videosize.x, m_videosize.y, m_videorgbabuffer);
-                        if (!m_videorawframe || !m_videorgbaframe)
+                        m_videorawframe = CreatePictureFrame(m_videocontext->pix_fmt, m_videosize.x, m_videosize.y, m_videorawbuffer, m_videorawbuffersize);
+                        if (!m_videorawframe)
                         {
                             std::cout << "Motion: Failed to create video frames" << std::endl;
                             m_videostreamid = -1;
@@ -173,6 +305,9 @@ namespace mt
                             int swapmode = SWS_FAST_BILINEAR;
                             if (m_videosize.x * m_videosize.y <= 500000 && m_videosize.x % 8 != 0) swapmode |= SWS_ACCURATE_RND;
                             m_videoswcontext = sws_getCachedContext(nullptr, m_videosize.x, m_videosize.y, m_videocontext->pix_fmt, m_videosize.x, m_videosize.y, AVPixelFormat::AV_PIX_FMT_RGBA, swapmode, nullptr, nullptr, nullptr);
+                            m_convertregion = Rect(0, 0, m_videosize.x, m_videosize.y);
+                            // a broken filter description still plays the file, unfiltered
+                            if (!CreateVideoFilter()) m_videofilterdescription.clear();
                         }
                     }
                 }
@@ -211,13 +346,14 @@ namespace mt
                         }
                         else
                         {
-                            if (av_samples_alloc(&m_audiopcmbuffer, nullptr, m_audiocontext->channels, av_samples_get_buffer_size(nullptr, m_audiocontext->channels, MAX_AUDIO_SAMPLES, AV_SAMPLE_FMT_S16, 0), AV_SAMPLE_FMT_S16, 0) < 0)
+                            if (av_samples_alloc(&m_audiopcmbuffer, nullptr, m_audiocontext->channels, MAX_AUDIO_SAMPLES, AV_SAMPLE_FMT_S16, 0) < 0)
                             {
                                 std::cout << "Motion: Failed to create audio samples buffer" << std::endl;
                                 m_audiostreamid = -1;
                             }
                             else
                             {
+                                m_memory->Charge(MemoryCategory::Staging, av_samples_get_buffer_size(nullptr, m_audiocontext->channels, MAX_AUDIO_SAMPLES, AV_SAMPLE_FMT_S16, 0));
                                 av_frame_unref(m_audiorawbuffer);
                                 m_audioswcontext = swr_alloc();
                                 uint64_t inchanlayout = m_audiocontext->channel_layout;
@@ -238,6 +374,12 @@ namespace mt
                 }
             }
         }
+        for (unsigned int i = 0; i < m_formatcontext->nb_streams; i++)
+        {
+            // the demuxer skips what is not decoded instead of handing it over packet by packet
+            bool selected = static_cast<int>(i) == m_videostreamid || static_cast<int>(i) == m_audiostreamid;
+            m_formatcontext->streams[i]->discard = selected ? AVDISCARD_DEFAULT : AVDISCARD_ALL;
+        }
         if (m_formatcontext->duration != AV_NOPTS_VALUE)
         {
 			m_filelength = std::chrono::microseconds(static_cast<int>(m_formatcontext->duration));
@@ -245,13 +387,35 @@ namespace mt
         }
         if (HasVideo() || HasAudio())
         {
+            m_lastreadposition = -1;
+            m_audiosynced = false;
+            m_audioanchorpts = std::chrono::microseconds(0);
+            m_nextvideopts = std::chrono::microseconds(0);
+            m_audiotempo.Reset();
+            m_direction = PlaybackDirection::Forward;
+            m_reverseframes.clear();
+            m_reverseupper = std::chrono::microseconds(0);
+            m_reversedone = false;
+            m_framecache.Clear();
+            m_loopprefetch.clear();
+            ResetLoop(std::chrono::microseconds(0));
+            m_seekdeferred = false;
+            m_producemean = 0;
+            m_producevariance = 0;
+            UpdateQueueDepth();
+            // nothing from a previous file may be played or anchor the clock
+            PlaybackListPtr playbacks = GetPlaybacks();
+            for (auto& audioplayback : playbacks->audio)
+            {
+                audioplayback->Flush();
+            }
             StartDecodeThread();
-			std::lock_guard<std::mutex> lock(m_playbacklock);
-            for (auto& videoplayback : m_videoplaybacks)
+            playbacks = GetPlaybacks();
+            for (auto& videoplayback : playbacks->video)
             {
                 videoplayback->SourceReloaded();
             }
-            for (auto& audioplayback : m_audioplaybacks)
+            for (auto& audioplayback : playbacks->audio)
             {
                 audioplayback->SourceReloaded();
             }
@@ -265,6 +429,98 @@ namespace mt
         }
     }
 
+    const std::vector<StreamInfo> DataSource::GetStreams()
+    {
+        std::vector<StreamInfo> streams;
+        if (!m_formatcontext) return streams;
+        for (unsigned int i = 0; i < m_formatcontext->nb_streams; i++)
+        {
+            AVStream* stream = m_formatcontext->streams[i];
+            StreamInfo info;
+            info.index = i;
+            info.codec = avcodec_get_name(stream->codec->codec_id);
+            AVDictionaryEntry* language = av_dict_get(stream->metadata, "language", nullptr, 0);
+            if (language) info.language = language->value;
+            AVDictionaryEntry* title = av_dict_get(stream->metadata, "title", nullptr, 0);
+            if (title) info.title = title->value;
+            info.isdefault = (stream->disposition & AV_DISPOSITION_DEFAULT) != 0;
+            info.selected = static_cast<int>(i) == m_videostreamid || static_cast<int>(i) == m_audiostreamid;
+            if (stream->duration != AV_NOPTS_VALUE) info.duration = std::chrono::microseconds(av_rescale_q(stream->duration, stream->time_base, AVRational{ 1, 1000000 }));
+            switch (stream->codec->codec_type)
+            {
+                case AVMEDIA_TYPE_VIDEO:
+                    info.type = StreamType::Video;
+                    info.width = stream->codec->width;
+                    info.height = stream->codec->height;
+                    break;
+                case AVMEDIA_TYPE_AUDIO:
+                    info.type = StreamType::Audio;
+                    info.samplerate = stream->codec->sample_rate;
+                    info.channelcount = stream->codec->channels;
+                    break;
+                case AVMEDIA_TYPE_SUBTITLE:
+                    info.type = StreamType::Subtitle;
+                    break;
+                default:
+                    break;
+            }
+            streams.push_back(info);
+        }
+        return streams;
+    }
+
+    const int DataSource::GetVideoStream()
+    {
+        return m_videostreamid;
+    }
+
+    const int DataSource::GetAudioStream()
+    {
+        return m_audiostreamid;
+    }
+
+    bool DataSource::SelectStreams(int VideoStream, int AudioStream)
+    {
+        if (!m_formatcontext) return false;
+        int streamcount = static_cast<int>(m_formatcontext->nb_streams);
+        if ((VideoStream != -1 && (VideoStream < 0 || VideoStream >= streamcount || m_formatcontext->streams[VideoStream]->codec->codec_type != AVMEDIA_TYPE_VIDEO)) ||
+            (AudioStream != -1 && (AudioStream < 0 || AudioStream >= streamcount || m_formatcontext->streams[AudioStream]->codec->codec_type != AVMEDIA_TYPE_AUDIO)))
+        {
+            std::cout << "Motion: Invalid stream selection" << std::endl;
+            return false;
+        }
+        if (VideoStream == -1 && AudioStream == -1)
+        {
+            std::cout << "Motion: Stream selection has no streams" << std::endl;
+            return false;
+        }
+        for (int stream : { VideoStream, AudioStream })
+        {
+            // everything that can be checked is checked before the current streams are torn down
+            if (stream != -1 && !avcodec_find_decoder(m_formatcontext->streams[stream]->codec->codec_id))
+            {
+                std::cout << "Motion: Failed to find codec for stream " << stream << std::endl;
+                return false;
+            }
+        }
+        if (VideoStream == m_videostreamid && AudioStream == m_audiostreamid) return true;
+        std::chrono::microseconds position = GetPlayingOffset();
+        State state = m_state;
+        std::string filename = m_filename;
+        int previousvideo = m_videostreamid;
+        int previousaudio = m_audiostreamid;
+        bool selected = Load(filename, VideoStream, AudioStream) && (VideoStream == -1 || HasVideo()) && (AudioStream == -1 || HasAudio());
+        // a decoder that still fails to open leaves the source where it was on the streams it had
+        if (!selected && !Load(filename, previousvideo, previousaudio)) return false;
+        if (position > std::chrono::microseconds(0)) SetPlayingOffset(position);
+        if (state != State::Stopped)
+        {
+            Play();
+            if (state == State::Paused) Pause();
+        }
+        return selected;
+    }
+
     const bool DataSource::HasVideo()
     {
         return m_videostreamid != -1;
@@ -277,7 +533,78 @@ namespace mt
 
     const Vector2 DataSource::GetVideoSize()
     {
-        return m_videosize;
+        return GetOutputSize();
+    }
+
+    const Vector2 DataSource::GetOutputSize()
+    {
+        if (!HasVideo()) return m_videosize;
+        Rect region = ClampRegion(m_videosize.x, m_videosize.y, 1, 1);
+        return Vector2(region.width, region.height);
+    }
+
+    const std::size_t DataSource::GetFrameBytes()
+    {
+        // what one converted frame takes with its rows padded to the alignment
+        Vector2 size = GetOutputSize();
+        return static_cast<std::size_t>(priv::VideoPacket::GetAlignedStride(size.x, m_rowalignment)) * std::max(size.y, 0);
+    }
+
+    const Rect DataSource::GetRegionOfInterest()
+    {
+        std::lock_guard<std::mutex> lock(m_regionlock);
+        return m_region;
+    }
+
+    void DataSource::SetRegionOfInterest(const Rect& Region)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_regionlock);
+            m_region = Region;
+        }
+        // cached frames were cut to the old region
+        m_framecache.Clear();
+    }
+
+    const FrameSinkPtr DataSource::GetFrameSink()
+    {
+        std::lock_guard<std::mutex> lock(m_sinklock);
+        return m_framesink;
+    }
+
+    void DataSource::SetFrameSink(FrameSinkPtr Sink)
+    {
+        std::lock_guard<std::mutex> lock(m_sinklock);
+        m_framesink = Sink;
+    }
+
+    const int DataSource::GetRowAlignment()
+    {
+        return m_rowalignment;
+    }
+
+    void DataSource::SetRowAlignment(int Bytes)
+    {
+        if (Bytes < 1 || Bytes > MAX_ROW_ALIGNMENT || (Bytes & (Bytes - 1)) != 0)
+        {
+            std::cout << "Motion: Invalid row alignment: " << Bytes << std::endl;
+            return;
+        }
+        m_rowalignment = Bytes;
+    }
+
+    Rect DataSource::ClampRegion(int Width, int Height, int AlignX, int AlignY)
+    {
+        // fits the region into a Width x Height frame, the corner moved down to the alignment
+        Rect region = GetRegionOfInterest();
+        if (region.width <= 0 || region.height <= 0) return Rect(0, 0, Width, Height);
+        region.left = std::max(0, std::min(region.left, Width - 1));
+        region.top = std::max(0, std::min(region.top, Height - 1));
+        region.left -= region.left % AlignX;
+        region.top -= region.top % AlignY;
+        region.width = std::min(region.width, Width - region.left);
+        region.height = std::min(region.height, Height - region.top);
+        return region;
     }
 
     const State DataSource::GetState()
@@ -328,10 +655,10 @@ namespace mt
     {
         if ((HasVideo() || HasAudio()) && m_state != State::Playing)
         {
+            if (m_seekdeferred) Seek(m_playingoffset);
             m_eofreached = false;
 			m_start = std::chrono::steady_clock::now();
-            NotifyStateChanged(State::Playing);
-            m_state = State::Playing;
+            SetState(State::Playing);
         }
     }
 
@@ -339,8 +666,7 @@ namespace mt
     {
         if (m_state == State::Playing)
         {
-            NotifyStateChanged(State::Paused);
-            m_state = State::Paused;
+            SetState(State::Paused);
         }
     }
 
@@ -349,8 +675,7 @@ namespace mt
         if (m_state != State::Stopped)
         {
             m_eofreached = true;
-            NotifyStateChanged(State::Stopped);
-            m_state = State::Stopped;
+            SetState(State::Stopped);
             m_eofreached = false;
             SetPlayingOffset(std::chrono::microseconds(0));
         }
@@ -363,83 +688,400 @@ namespace mt
 
     const std::chrono::microseconds DataSource::GetPlayingOffset()
     {
-
-        return m_playingoffset;
+        return MapLoopOffset(m_playingoffset);
     }
 
     void DataSource::SetPlayingOffset(std::chrono::microseconds PlayingOffset)
+    {
+        // scrubbing while not playing is served from the frame cache, the decoder only seeks once playback needs it
+        if (m_state != State::Playing && PresentCachedFrame(PlayingOffset)) return;
+        Seek(PlayingOffset);
+    }
+
+    void DataSource::Seek(std::chrono::microseconds PlayingOffset)
     {
         if (HasVideo() || HasAudio())
         {
+            m_seekdeferred = false;
             StopDecodeThread();
+            FlushParkedPackets();
+            {
+                // Stop() notifies the playbacks while the decoder is still running, drop whatever it wrote since
+                PlaybackListPtr playbacks = GetPlaybacks();
+                for (auto& audioplayback : playbacks->audio)
+                {
+                    audioplayback->Flush();
+                }
+            }
 			m_playingoffset = PlayingOffset;
             m_playingtoeof = false;
             bool startplaying = m_state == State::Playing;
             if (m_state != State::Stopped)
             {
                 m_eofreached = true;
-                NotifyStateChanged(State::Stopped);
-                m_state = State::Stopped;
+                SetState(State::Stopped);
                 m_eofreached = false;
             }
-			auto seconds = std::chrono::duration_cast<std::chrono::seconds>(PlayingOffset);
-            if (HasVideo())
-            {
-                AVRational timebase = m_formatcontext->streams[m_videostreamid]->time_base;
-                float ftb = (float)timebase.den / (float)timebase.num;
-                int64_t pos = static_cast<int64_t>(seconds.count() * ftb);
-                av_seek_frame(m_formatcontext, m_videostreamid, pos, AVSEEK_FLAG_ANY);
-                avcodec_flush_buffers(m_videocontext);
-            }
-            if (HasAudio())
-            {
-                AVRational timebase = m_formatcontext->streams[m_audiostreamid]->time_base;
-                float ftb = (float)timebase.den / (float)timebase.num;
-				int64_t pos = static_cast<int64_t>(seconds.count() * ftb);
-                av_seek_frame(m_formatcontext, m_audiostreamid, pos, AVSEEK_FLAG_ANY);
-                avcodec_flush_buffers(m_audiocontext);
-            }
+            SeekDemuxer(PlayingOffset);
+            m_audiotempo.Reset();
+            ResetLoop(PlayingOffset);
+            m_reverseframes.clear();
+            m_reverseupper = PlayingOffset;
+            m_reversedone = false;
+            m_seekstart = std::chrono::steady_clock::now();
+            m_seekpending = true;
+            priv::IncrementStat(m_stats.seekcount);
             StartDecodeThread();
             if (startplaying) Play();
         }
     }
 
+    void DataSource::SeekDemuxer(std::chrono::microseconds PlayingOffset)
+    {
+        // expects the decoder to be stopped or to be the caller
+		auto seconds = std::chrono::duration_cast<std::chrono::seconds>(PlayingOffset);
+        if (HasVideo())
+        {
+            AVRational timebase = m_formatcontext->streams[m_videostreamid]->time_base;
+            float ftb = (float)timebase.den / (float)timebase.num;
+            int64_t pos = static_cast<int64_t>(seconds.count() * ftb);
+            av_seek_frame(m_formatcontext, m_videostreamid, pos, AVSEEK_FLAG_ANY);
+            avcodec_flush_buffers(m_videocontext);
+        }
+        if (HasAudio())
+        {
+            AVRational timebase = m_formatcontext->streams[m_audiostreamid]->time_base;
+            float ftb = (float)timebase.den / (float)timebase.num;
+			int64_t pos = static_cast<int64_t>(seconds.count() * ftb);
+            av_seek_frame(m_formatcontext, m_audiostreamid, pos, AVSEEK_FLAG_ANY);
+            avcodec_flush_buffers(m_audiocontext);
+        }
+        m_lastreadposition = -1;
+        m_audiosynced = false;
+        m_audioanchorpts = PlayingOffset;
+        m_nextvideopts = PlayingOffset;
+        m_videofilter.Flush();
+    }
+
+    void DataSource::ResetLoop(std::chrono::microseconds PlayingOffset)
+    {
+        // expects the decoder to be stopped, every seek starts counting from the file's own timestamps
+        m_loopshift = std::chrono::microseconds(0);
+        m_looplength = m_loopend > m_loopstart ? m_loopend - m_loopstart : 0;
+        m_loopresume = PlayingOffset;
+        m_loopskipuntil = std::chrono::microseconds::min();
+        m_loopfeed = 0;
+        m_looppending = 0;
+        m_loopwrap = false;
+        m_loopcapturing = false;
+        m_loopprefetchpending = false;
+        m_nextaudiopts = PlayingOffset;
+        if (!m_looping || !HasVideo() || !m_loopprefetch.empty()) return;
+        // starting at the loop start the first frames are kept on the way past, otherwise the
+        // decoder fetches them before it goes to where playback starts
+        if (PlayingOffset.count() <= m_loopstart) m_loopcapturing = true;
+        else m_loopprefetchpending = true;
+    }
+
+    void DataSource::SeekLoopStart()
+    {
+        // decode thread only, lands on the key frame at or before the loop start
+        int streamid = HasVideo() ? m_videostreamid : m_audiostreamid;
+        AVStream* stream = m_formatcontext->streams[streamid];
+        int64_t start = m_loopstart + (m_formatcontext->start_time != AV_NOPTS_VALUE ? m_formatcontext->start_time : 0);
+        int64_t target = av_rescale_q(start, AVRational{ 1, 1000000 }, stream->time_base);
+        if (av_seek_frame(m_formatcontext, streamid, target, AVSEEK_FLAG_BACKWARD) < 0)
+        {
+            av_seek_frame(m_formatcontext, streamid, stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0, AVSEEK_FLAG_BACKWARD);
+        }
+        if (HasVideo()) avcodec_flush_buffers(m_videocontext);
+        if (HasAudio()) avcodec_flush_buffers(m_audiocontext);
+        m_videofilter.Flush();
+        m_lastreadposition = -1;
+        m_audiosynced = false;
+        m_audioanchorpts = std::chrono::microseconds(m_loopstart.load());
+        m_nextvideopts = std::chrono::microseconds(m_loopstart.load());
+    }
+
+    void DataSource::PrefetchLoop()
+    {
+        // decode thread only.  Playback starts inside the loop, decode its first frames now so
+        // the first wrap already has them, then go to where playback really starts
+        MT_TRACE_SCOPE("prefetch loop");
+        m_loopprefetchpending = false;
+        SeekLoopStart();
+        m_loopcapturing = true;
+        AVPacket packet;
+        while (m_loopcapturing && !m_loopwrap && m_shouldthreadrun)
+        {
+            av_init_packet(&packet);
+            packet.data = nullptr;
+            packet.size = 0;
+            if (av_read_frame(m_formatcontext, &packet) < 0) break;
+            RecordBytesRead();
+            if (packet.stream_index == m_videostreamid && DecodeVideoPacket(&packet))
+            {
+                ConvertVideoFrame([](const priv::VideoPacketPtr&) { });
+            }
+            av_free_packet(&packet);
+        }
+        m_loopcapturing = false;
+        m_loopwrap = false;
+        SeekDemuxer(m_loopresume);
+    }
+
+    bool DataSource::WrapLoop()
+    {
+        // decode thread only.  Starts the next pass without stopping anything: the prefetched
+        // frames go out while the decoder seeks back and works through the first GOP again, and
+        // the timestamps keep counting up so the playbacks never see a jump.  False when the loop
+        // turned out to hold nothing.
+        MT_TRACE_SCOPE("wrap loop");
+        std::chrono::microseconds start(m_loopstart.load());
+        std::chrono::microseconds end = m_loopwrap ? std::chrono::microseconds(m_loopend.load()) : (HasVideo() ? m_nextvideopts : m_nextaudiopts);
+        m_loopwrap = false;
+        if (end <= start) return false;
+        m_looplength = (end - start).count();
+        m_loopshift += end - start;
+        // anything parked was read past the end of the loop
+        FlushParkedPackets();
+        Vector2 size = GetOutputSize();
+        if (!m_loopprefetch.empty() && (m_loopprefetch.front()->width != size.x || m_loopprefetch.front()->height != size.y))
+        {
+            // the region changed since the frames were kept
+            m_loopprefetch.clear();
+        }
+        m_loopfeed = 0;
+        m_looppending = m_loopprefetch.size();
+        m_loopskipuntil = m_loopprefetch.empty() ? std::chrono::microseconds::min() : m_loopprefetch.back()->pts;
+        m_loopcapturing = m_loopprefetch.empty() && HasVideo();
+        SeekLoopStart();
+        priv::IncrementStat(m_stats.loopwraps);
+        return true;
+    }
+
+    bool DataSource::FeedLoopFrame()
+    {
+        // decode thread only, hands out the next prefetched frame once the playbacks have room
+        {
+            PlaybackListPtr playbacks = GetPlaybacks();
+            if (HasConsumers(*playbacks, m_videostreamid) && !HasRoom(*playbacks, m_videostreamid)) return false;
+        }
+        // every pass shares the prefetched pixels and only carries its own shifted timestamp
+        const priv::VideoPacketPtr& prefetched = m_loopprefetch[m_loopfeed];
+        priv::VideoPacketPtr packet(std::make_shared<priv::VideoPacket>(prefetched, prefetched->pts + m_loopshift));
+        m_loopfeed++;
+        m_looppending--;
+        PushVideoPacket(packet);
+        RecordSeekLatency();
+        return true;
+    }
+
+    bool DataSource::IsOutsideLoop(std::chrono::microseconds Pts)
+    {
+        // reverse playback ignores the loop
+        if (!m_looping || m_direction == PlaybackDirection::Reverse) return false;
+        long long end = m_loopend;
+        return Pts.count() < m_loopstart || (end > m_loopstart && Pts.count() >= end);
+    }
+
+    std::chrono::microseconds DataSource::MapLoopOffset(std::chrono::microseconds Offset)
+    {
+        // every pass is shifted by the loop length, fold the player's offset back into the loop
+        long long length = m_looplength;
+        long long start = m_loopstart;
+        if (!m_looping || length <= 0 || Offset.count() < start + length) return Offset;
+        return std::chrono::microseconds(start + (Offset.count() - start) % length);
+    }
+
+    const DataSource::PlaybackListPtr DataSource::GetPlaybacks()
+    {
+        return std::atomic_load(&m_playbacks);
+    }
+
+    void DataSource::PublishPlaybacks(std::unique_ptr<PlaybackList> Playbacks)
+    {
+        // expects m_playbacklock to be held, readers still walking the old list keep it and its consumers alive
+        std::atomic_store(&m_playbacks, PlaybackListPtr(std::move(Playbacks)));
+    }
+
+    void DataSource::AttachPlayback(const priv::VideoConsumerPtr& Consumer)
+    {
+        std::lock_guard<std::mutex> lock(m_playbacklock);
+        std::unique_ptr<PlaybackList> playbacks(new PlaybackList(*GetPlaybacks()));
+        playbacks->video.push_back(Consumer);
+        PublishPlaybacks(std::move(playbacks));
+    }
+
+    void DataSource::AttachPlayback(const priv::AudioConsumerPtr& Consumer)
+    {
+        std::lock_guard<std::mutex> lock(m_playbacklock);
+        std::unique_ptr<PlaybackList> playbacks(new PlaybackList(*GetPlaybacks()));
+        playbacks->audio.push_back(Consumer);
+        PublishPlaybacks(std::move(playbacks));
+    }
+
+    void DataSource::DetachPlayback(const priv::VideoConsumerPtr& Consumer)
+    {
+        std::lock_guard<std::mutex> lock(m_playbacklock);
+        std::unique_ptr<PlaybackList> playbacks(new PlaybackList(*GetPlaybacks()));
+        playbacks->video.erase(std::remove(playbacks->video.begin(), playbacks->video.end(), Consumer), playbacks->video.end());
+        PublishPlaybacks(std::move(playbacks));
+    }
+
+    void DataSource::DetachPlayback(const priv::AudioConsumerPtr& Consumer)
+    {
+        std::lock_guard<std::mutex> lock(m_playbacklock);
+        std::unique_ptr<PlaybackList> playbacks(new PlaybackList(*GetPlaybacks()));
+        playbacks->audio.erase(std::remove(playbacks->audio.begin(), playbacks->audio.end(), Consumer), playbacks->audio.end());
+        if (playbacks->masterclock == Consumer) playbacks->masterclock = nullptr;
+        PublishPlaybacks(std::move(playbacks));
+    }
+
     void DataSource::NotifyStateChanged(State NewState)
     {
-		std::lock_guard<std::mutex> lock(m_playbacklock);
-        for (auto& videoplayback : m_videoplaybacks)
+        PlaybackListPtr playbacks = GetPlaybacks();
+        for (auto& videoplayback : playbacks->video)
         {
             videoplayback->StateChanged(m_state, NewState);
         }
-        for (auto& audioplayback : m_audioplaybacks)
+        for (auto& audioplayback : playbacks->audio)
         {
             audioplayback->StateChanged(m_state, NewState);
         }
     }
 
+    void DataSource::SetState(State NewState)
+    {
+        State previousstate = m_state;
+        NotifyStateChanged(NewState);
+        m_state = NewState;
+        // signalled once the new state is readable, a host woken by it must not see the old one
+        m_ready.Signal();
+        {
+            PlaybackListPtr playbacks = GetPlaybacks();
+            for (auto& videoplayback : playbacks->video)
+            {
+                videoplayback->m_ready.Signal();
+            }
+        }
+        StateChangedCallback callback;
+        Executor executor;
+        {
+            std::lock_guard<std::mutex> lock(m_callbacklock);
+            callback = m_statechangedcallback;
+            executor = m_statechangedexecutor;
+        }
+        if (!callback) return;
+        if (executor) executor([this, callback, previousstate, NewState]() { callback(*this, previousstate, NewState); });
+        else callback(*this, previousstate, NewState);
+    }
+
+    void DataSource::NotifyFrameReady(std::chrono::microseconds Pts)
+    {
+        m_ready.Signal();
+        FrameReadyCallback callback;
+        Executor executor;
+        {
+            std::lock_guard<std::mutex> lock(m_callbacklock);
+            if (!m_framereadycallback) return;
+            callback = m_framereadycallback;
+            executor = m_framereadyexecutor;
+        }
+        if (executor) executor([this, callback, Pts]() { callback(*this, Pts); });
+        else callback(*this, Pts);
+    }
+
+    void DataSource::SetFrameReadyCallback(FrameReadyCallback Callback, Executor Executor)
+    {
+        std::lock_guard<std::mutex> lock(m_callbacklock);
+        m_framereadycallback = std::move(Callback);
+        m_framereadyexecutor = std::move(Executor);
+    }
+
+    void DataSource::SetStateChangedCallback(StateChangedCallback Callback, Executor Executor)
+    {
+        std::lock_guard<std::mutex> lock(m_callbacklock);
+        m_statechangedcallback = std::move(Callback);
+        m_statechangedexecutor = std::move(Executor);
+    }
+
+    const int DataSource::GetReadyFd()
+    {
+        return m_ready.GetFd();
+    }
+
+    void DataSource::ClearReady()
+    {
+        m_ready.Clear();
+    }
+
     void DataSource::Update()
     {
-        if (m_playingoffset > m_filelength)
+        MT_TRACE_SCOPE("DataSource::Update");
+        bool reverse = m_direction == PlaybackDirection::Reverse;
+        if (!reverse && !m_looping && m_playingoffset > m_filelength)
         {
             Stop();
             m_eofreached = true;
         }
+        else if (reverse && m_state == State::Playing && m_playingoffset.count() <= 0)
+        {
+            // stopping would rewind to the start anyway, stay on the first frame instead
+            Pause();
+            m_eofreached = true;
+        }
 
 		auto now = std::chrono::steady_clock::now();
 		auto deltatime = now - m_start;
 		m_start = now;
-		auto duration = std::chrono::duration_cast<std::chrono::microseconds>(deltatime);
-
-        if (m_state == State::Playing)
-        {			
-	        m_playingoffset += std::chrono::microseconds(duration);
-        }
+        float speed = m_playbackspeed;
+		auto duration = std::chrono::microseconds(static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(deltatime).count() * speed));
 
-		std::lock_guard<std::mutex> lock(m_playbacklock);
-        for (auto& videoplayback : m_videoplaybacks)
         {
-            videoplayback->Update(duration);
+            PlaybackListPtr playbacks = GetPlaybacks();
+            // once the master has played out its last sample the clock free runs so trailing video still finishes
+            priv::AudioConsumer* masterclock = reverse ? nullptr : playbacks->masterclock.get();
+            bool masterdrained = masterclock && m_playingtoeof && masterclock->GetBufferedFrameCount() == 0;
+            if (m_state == State::Playing)
+            {
+                if (reverse)
+                {
+                    m_playingoffset = std::max(m_playingoffset - duration, std::chrono::microseconds(0));
+                }
+                else if (masterclock && !masterdrained)
+                {
+                    if (masterclock->HasClock()) m_playingoffset = masterclock->GetClock();
+                }
+                else
+                {
+                    m_playingoffset += std::chrono::microseconds(duration);
+                }
+            }
+            // frame counting assumes every frame gets decoded, with skipping only timestamps tell where we are
+            bool byclock = reverse || masterclock || speed != 1.f;
+            for (auto& videoplayback : playbacks->video)
+            {
+                if (byclock) videoplayback->UpdateToClock(m_playingoffset, reverse);
+                else videoplayback->Update(duration);
+            }
+            UpdateDeadline(*playbacks);
         }
+        RequestDecode();
+    }
+
+    void DataSource::SetMasterClock(AudioPlayback* Playback)
+    {
+        std::lock_guard<std::mutex> lock(m_playbacklock);
+        std::unique_ptr<PlaybackList> playbacks(new PlaybackList(*GetPlaybacks()));
+        playbacks->masterclock = Playback && Playback->m_consumer->m_datasource == this ? Playback->m_consumer : nullptr;
+        PublishPlaybacks(std::move(playbacks));
+    }
+
+    AudioPlayback* DataSource::GetMasterClock()
+    {
+        PlaybackListPtr playbacks = GetPlaybacks();
+        return playbacks->masterclock ? playbacks->masterclock->m_playback : nullptr;
     }
 
     const float DataSource::GetPlaybackSpeed()
@@ -449,138 +1091,871 @@ namespace mt
 
     void DataSource::SetPlaybackSpeed(float PlaybackSpeed)
     {
-        m_playbackspeed = PlaybackSpeed;
-		std::lock_guard<std::mutex> lock(m_playbacklock);
-        for (auto& audioplayback : m_audioplaybacks)
-        {
-            //audioplayback->setPitch(PlaybackSpeed);
-        }
+        // the decoder picks the new speed up with its next chunk of audio
+        m_playbackspeed = std::max(MIN_PLAYBACK_SPEED, std::min(MAX_PLAYBACK_SPEED, PlaybackSpeed));
     }
 
     void DataSource::StartDecodeThread()
     {
         if (m_shouldthreadrun) return;
         m_shouldthreadrun = true;
-        m_decodethread.reset(new std::thread(&DataSource::DecodeThreadRun, this));
+        if (m_decodemode == DecodeMode::SharedScheduler)
+        {
+            DecodeScheduler::GetInstance().Submit(this);
+        }
+        else
+        {
+            m_decodethread.reset(new std::thread(&DataSource::DecodeThreadRun, this));
+        }
     }
 
     void DataSource::StopDecodeThread()
     {
         if (!m_shouldthreadrun) return;
-        m_shouldthreadrun = false;
-        if (m_decodethread->joinable()) m_decodethread->join();
-        m_decodethread.reset(nullptr);
+        {
+            std::lock_guard<std::mutex> lock(m_wakelock);
+            m_shouldthreadrun = false;
+            m_wakecondition.notify_one();
+        }
+        if (m_decodethread)
+        {
+            if (m_decodethread->joinable()) m_decodethread->join();
+            m_decodethread.reset(nullptr);
+        }
+        else
+        {
+            DecodeScheduler::GetInstance().Cancel(this);
+        }
     }
 
-    void DataSource::DecodeThreadRun()
+    void DataSource::RequestDecode()
     {
-        while (m_shouldthreadrun)
+        // decoders go idle once their playbacks are full, wake them as soon as there is room again
+        if (!m_shouldthreadrun || m_playingtoeof || IsFull()) return;
+        if (m_decodemode == DecodeMode::SharedScheduler)
+        {
+            DecodeScheduler::GetInstance().Submit(this);
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(m_wakelock);
+            m_wakepending = true;
+            m_wakecondition.notify_one();
+        }
+    }
+
+    void DataSource::WakeReaders()
+    {
+        // frame readers block on or await their queue, they also have to learn about the end of the file
+        std::vector<std::function<void()>> completed;
         {
-            bool isfull = IsFull();
-            while (!isfull && m_shouldthreadrun && !m_playingtoeof)
+            PlaybackListPtr playbacks = GetPlaybacks();
+            for (auto& videoplayback : playbacks->video)
             {
-                bool validpacket = false;
-                while (!validpacket && m_shouldthreadrun)
+                if (!videoplayback->m_offline) continue;
                 {
-                    AVPacket* packet;
-                    packet = (AVPacket*)av_malloc(sizeof(*packet));
-                    av_init_packet(packet);
-                    if (av_read_frame(m_formatcontext, packet) == 0)
-                    {
-                        if (packet->stream_index == m_videostreamid)
-                        {
-                            int decoderesult = 0;
-                            if (avcodec_decode_video2(m_videocontext, m_videorawframe, &decoderesult, packet) >= 0)
-                            {
-                                if (decoderesult)
-                                {
-                                    if (sws_scale(m_videoswcontext, m_videorawframe->data, m_videorawframe->linesize, 0, m_videocontext->height, m_videorgbaframe->data, m_videorgbaframe->linesize))
-                                    {
-                                        validpacket = true;
-                                        priv::VideoPacketPtr packet(std::make_shared<priv::VideoPacket>(m_videorgbaframe->data[0], m_videosize.x, m_videosize.y));
-                                        {
-											std::lock_guard<std::mutex> lock(m_playbacklock);
-                                            for (auto& videoplayback : m_videoplaybacks)
-                                            {
-												std::lock_guard<std::mutex> lock(videoplayback->m_protectionlock);
-                                                videoplayback->m_queuedvideopackets.push(packet);
-                                            }
-                                        }
-                                        isfull = IsFull();
-                                    }
-                                }
-                            }
-                        }
-                        else if (packet->stream_index == m_audiostreamid)
-                        {
-                            int decoderesult = 0;
-                            if (avcodec_decode_audio4(m_audiocontext, m_audiorawbuffer, &decoderesult, packet) > 0)
-                            {
-                                if (decoderesult)
-                                {
-                                    int convertlength = swr_convert(m_audioswcontext, &m_audiopcmbuffer, m_audiorawbuffer->nb_samples, (const uint8_t**)m_audiorawbuffer->extended_data, m_audiorawbuffer->nb_samples);
-                                    if (convertlength > 0)
-                                    {
-                                        validpacket = true;
-                                        priv::AudioPacketPtr packet(std::make_shared<priv::AudioPacket>(m_audiopcmbuffer, convertlength, m_audiochannelcount));
-                                        {
-											std::lock_guard<std::mutex> lock(m_playbacklock);
-                                            for (auto& audioplayback : m_audioplaybacks)
-                                            {
-												std::lock_guard<std::mutex> lock(audioplayback->m_protectionlock);
-                                                audioplayback->m_queuedaudiopackets.push(packet);
-                                            }
-                                        }
-                                        isfull = IsFull();
-                                    }
-                                }
-                            }
-                        }
-                        av_free_packet(packet);
-                        av_free(packet);
-                    }
-                    else
-                    {
-                        m_playingtoeof = true;
-                        validpacket = true;
-                        av_free_packet(packet);
-                        av_free(packet);
-                    }
+                    std::lock_guard<std::mutex> lock(videoplayback->m_protectionlock);
+                    videoplayback->m_framequeued.notify_all();
                 }
+                std::function<void()> task = videoplayback->TakePending();
+                if (task) completed.push_back(std::move(task));
             }
-            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        // callbacks without an executor run right here and may request the next frame straight away
+        for (auto& task : completed)
+        {
+            task();
         }
     }
 
-    bool DataSource::IsFull()
+    void DataSource::DecodeThreadRun()
     {
-		std::lock_guard<std::mutex> lock(m_playbacklock);
-        if (HasVideo())
+        MT_TRACE_THREAD_NAME("Motion decode thread");
+        while (m_shouldthreadrun)
         {
-            for (auto& videoplayback : m_videoplaybacks)
+            if (m_priority == DecodePriority::Low)
             {
-				std::lock_guard<std::mutex> lock(videoplayback->m_protectionlock);
-                if (videoplayback->m_queuedvideopackets.size() < PACKET_QUEUE_AMOUNT)
+                // the same order the shared scheduler keeps: a low priority source gives its core up
+                // between short slices so higher priority decoders get to it first
+                while (m_shouldthreadrun && DecodeSlice(LOW_PRIORITY_SLICE_FRAMES))
                 {
-                    return false;
+                    std::this_thread::yield();
                 }
             }
+            else
+            {
+                DecodeSlice(0);
+            }
+            // the timeout keeps the old polling for anything that does not call RequestDecode
+            std::unique_lock<std::mutex> lock(m_wakelock);
+            m_wakecondition.wait_for(lock, std::chrono::milliseconds(5), [this]() { return m_wakepending || !m_shouldthreadrun; });
+            m_wakepending = false;
+        }
+    }
+
+    bool DataSource::DecodeSlice(std::size_t FrameLimit)
+    {
+        if (m_direction == PlaybackDirection::Reverse) return DecodeReverseSlice();
+        if (m_loopprefetchpending) PrefetchLoop();
+        {
+            // samples that did not fit into a ring last time go before anything new is decoded
+            PlaybackListPtr playbacks = GetPlaybacks();
+            for (auto& audioplayback : playbacks->audio)
+            {
+                audioplayback->WriteOverflow();
+            }
+        }
+        // the limit counts video frames handed to the playbacks, sources without video count the
+        // packets that produced samples
+        m_slicevideoframes = 0;
+        std::size_t packetcount = 0;
+        if (HasVideo())
+        {
+            // a low priority source that already fell behind only decodes reference frames until it catches up
+            bool throttle = m_priority == DecodePriority::Low && m_state == State::Playing && IsBehind();
+            // fast playback shows a fraction of the frames anyway, do not pay for decoding the rest
+            float speed = m_playbackspeed;
+            if (m_offlinereaders > 0) m_videocontext->skip_frame = AVDISCARD_DEFAULT;
+            else if (speed >= SPEED_SKIP_NONKEY) m_videocontext->skip_frame = AVDISCARD_NONKEY;
+            else if (speed >= SPEED_SKIP_NONREF || throttle) m_videocontext->skip_frame = AVDISCARD_NONREF;
+            else m_videocontext->skip_frame = AVDISCARD_DEFAULT;
         }
-        else if (HasAudio())
+        bool isfull = IsFull();
+        while (!isfull && m_shouldthreadrun && !m_playingtoeof)
         {
-            for (auto& audioplayback : m_audioplaybacks)
+            if (FrameLimit != 0 && (HasVideo() ? m_slicevideoframes : packetcount) >= FrameLimit) return true;
+            bool validpacket = false;
+            while (!validpacket && !isfull && m_shouldthreadrun)
             {
-				std::lock_guard<std::mutex> lock(audioplayback->m_protectionlock);
-                if (audioplayback->m_queuedaudiopackets.size() < PACKET_QUEUE_AMOUNT)
+                if (m_looppending > 0 && FeedLoopFrame())
                 {
+                    validpacket = true;
+                    isfull = IsFull();
+                    continue;
+                }
+                // packets parked while their stream was full go first, in the order they were read
+                AVPacket* packet = TakeParkedPacket();
+                if (!packet && !m_demuxeof)
+                {
+                    packet = ReadPacket();
+                    bool park = false;
+                    if (!packet) m_demuxeof = true;
+                    else
+                    {
+                        PlaybackListPtr playbacks = GetPlaybacks();
+                        park = HasConsumers(*playbacks, packet->stream_index) && !HasRoom(*playbacks, packet->stream_index);
+                    }
+                    if (park)
+                    {
+                        // only read for the other stream, this one waits compressed until its consumers catch up
+                        ParkPacket(packet);
+                        isfull = IsFull();
+                        continue;
+                    }
+                }
+                if (!packet)
+                {
+                    if (m_demuxeof && m_parkedcount == 0)
+                    {
+                        if (m_looping && WrapLoop()) continue;
+                        m_playingtoeof = true;
+                        WakeReaders();
+                    }
                     return false;
                 }
+                validpacket = DecodePacket(packet);
+                if (m_loopwrap && !WrapLoop())
+                {
+                    m_playingtoeof = true;
+                    WakeReaders();
+                    return false;
+                }
+                if (validpacket) isfull = IsFull();
+            }
+            packetcount++;
+        }
+        return false;
+    }
+
+    AVPacket* DataSource::ReadPacket()
+    {
+        AVPacket* packet;
+        packet = (AVPacket*)av_malloc(sizeof(*packet));
+        av_init_packet(packet);
+        auto readstart = std::chrono::steady_clock::now();
+        int readresult = av_read_frame(m_formatcontext, packet);
+        auto readend = std::chrono::steady_clock::now();
+        m_stats.readtime.Record(readend - readstart);
+        MT_TRACE_EVENT("av_read_frame", readstart, readend);
+        RecordBytesRead();
+        if (readresult != 0)
+        {
+            av_free_packet(packet);
+            av_free(packet);
+            return nullptr;
+        }
+        return packet;
+    }
+
+    bool DataSource::DecodePacket(AVPacket* Packet)
+    {
+        // takes ownership of the packet, true when it produced a frame or samples
+        bool validpacket = false;
+        if (Packet->stream_index == m_videostreamid)
+        {
+            auto producestart = std::chrono::steady_clock::now();
+            if (DecodeVideoPacket(Packet))
+            {
+                validpacket = ConvertVideoFrame([&](const priv::VideoPacketPtr& VideoPacket)
+                {
+                    RecordProduceTime(std::chrono::steady_clock::now() - producestart);
+                    PushVideoPacket(VideoPacket);
+                    RecordSeekLatency();
+                    producestart = std::chrono::steady_clock::now();
+                });
+            }
+        }
+        else if (Packet->stream_index == m_audiostreamid)
+        {
+            int decoderesult = 0;
+            auto decodestart = std::chrono::steady_clock::now();
+            int decodelength = avcodec_decode_audio4(m_audiocontext, m_audiorawbuffer, &decoderesult, Packet);
+            auto decodeend = std::chrono::steady_clock::now();
+            m_stats.decodetime.Record(decodeend - decodestart);
+            MT_TRACE_EVENT("decode audio", decodestart, decodeend);
+            if (decodelength > 0)
+            {
+                int64_t timestamp = av_frame_get_best_effort_timestamp(m_audiorawbuffer);
+                auto rawpts = StreamTimeToOffset(m_audiostreamid, timestamp);
+                if (decoderesult && timestamp != AV_NOPTS_VALUE && IsOutsideLoop(rawpts))
+                {
+                    // with video the frames decide when the next pass starts
+                    if (!HasVideo() && rawpts.count() >= m_loopstart) m_loopwrap = true;
+                }
+                else if (decoderesult)
+                {
+                    priv::IncrementStat(m_stats.decodedaudioframes);
+                    auto pts = SyncAudioTimestamp(timestamp, m_audiorawbuffer->nb_samples);
+                    // compensation may stretch the chunk, leave the converter the whole buffer
+                    int convertlength = swr_convert(m_audioswcontext, &m_audiopcmbuffer, MAX_AUDIO_SAMPLES, (const uint8_t**)m_audiorawbuffer->extended_data, m_audiorawbuffer->nb_samples);
+                    if (convertlength > 0)
+                    {
+                        validpacket = true;
+                        m_audiosamplecount += convertlength;
+                        m_nextaudiopts = pts + std::chrono::microseconds(static_cast<long long>(convertlength) * 1000000 / m_audiocontext->sample_rate);
+                        pts += m_loopshift;
+                        const int16_t* samples = reinterpret_cast<int16_t*>(m_audiopcmbuffer);
+                        float speed = m_playbackspeed;
+                        m_audiotempo.Configure(m_audiocontext->sample_rate, av_get_default_channel_layout(m_audiochannelcount), speed);
+                        if (m_audiotempo.IsActive())
+                        {
+                            m_audiotempo.Process(samples, convertlength, [&](const int16_t* Samples, int FrameCount)
+                            {
+                                PushAudio(Samples, FrameCount, pts, speed);
+                            });
+                        }
+                        else
+                        {
+                            PushAudio(samples, convertlength, pts, 1.f);
+                        }
+                        if (!HasVideo())
+                        {
+                            RecordProduceTime(std::chrono::steady_clock::now() - decodestart);
+                            RecordSeekLatency();
+                        }
+                    }
+                }
+            }
+        }
+        av_free_packet(Packet);
+        av_free(Packet);
+        return validpacket;
+    }
+
+    void DataSource::ParkPacket(AVPacket* Packet)
+    {
+        // demuxer owned data is only valid until the next read, a parked packet needs its own reference
+        if (!Packet->buf)
+        {
+            AVPacket owned;
+            av_init_packet(&owned);
+            if (av_packet_ref(&owned, Packet) < 0)
+            {
+                av_free_packet(Packet);
+                av_free(Packet);
+                return;
+            }
+            av_free_packet(Packet);
+            *Packet = owned;
+        }
+        std::size_t size = static_cast<std::size_t>(Packet->size);
+        if (Packet->stream_index == m_videostreamid) m_parkedvideo.push_back(Packet);
+        else m_parkedaudio.push_back(Packet);
+        m_parkedcount++;
+        m_parkedbytes += size;
+        m_memory->Charge(MemoryCategory::Staging, size);
+    }
+
+    AVPacket* DataSource::TakeParkedPacket()
+    {
+        // decode thread only, the oldest packet of a stream whose consumers have room again
+        if (m_parkedcount == 0) return nullptr;
+        std::deque<AVPacket*>* parked = nullptr;
+        {
+            PlaybackListPtr playbacks = GetPlaybacks();
+            if (!m_parkedvideo.empty() && (HasRoom(*playbacks, m_videostreamid) || !HasConsumers(*playbacks, m_videostreamid))) parked = &m_parkedvideo;
+            else if (!m_parkedaudio.empty() && (HasRoom(*playbacks, m_audiostreamid) || !HasConsumers(*playbacks, m_audiostreamid))) parked = &m_parkedaudio;
+        }
+        if (!parked) return nullptr;
+        AVPacket* packet = parked->front();
+        parked->pop_front();
+        std::size_t size = static_cast<std::size_t>(packet->size);
+        m_parkedcount--;
+        m_parkedbytes -= size;
+        m_memory->Release(MemoryCategory::Staging, size);
+        return packet;
+    }
+
+    void DataSource::FlushParkedPackets()
+    {
+        // expects the decoder to be stopped
+        for (auto parked : { &m_parkedvideo, &m_parkedaudio })
+        {
+            for (auto packet : *parked)
+            {
+                m_memory->Release(MemoryCategory::Staging, static_cast<std::size_t>(packet->size));
+                av_free_packet(packet);
+                av_free(packet);
+            }
+            parked->clear();
+        }
+        m_parkedcount = 0;
+        m_parkedbytes = 0;
+        m_demuxeof = false;
+    }
+
+    bool DataSource::DecodeReverseSlice()
+    {
+        // hand out what is cached first, then decode the segment before it while that plays
+        FeedReverseFrames();
+        std::size_t framebytes = GetFrameBytes();
+        if (!m_reversedone && m_shouldthreadrun && m_reverseframes.size() * framebytes <= m_reversecachelimit / 2)
+        {
+            DecodeReverseSegment();
+            FeedReverseFrames();
+        }
+        m_playingtoeof = m_reversedone && m_reverseframes.empty();
+        if (m_playingtoeof) WakeReaders();
+        return !m_reversedone && m_reverseframes.size() * framebytes <= m_reversecachelimit / 2;
+    }
+
+    void DataSource::DecodeReverseSegment()
+    {
+        // decodes forward from the key frame before m_reverseupper and keeps the frames just below
+        // it, at most half the cache.  When a GOP does not fit the next pass starts from the same
+        // key frame again and picks up where this one stopped.  It runs on the decode thread that
+        // feeds the playbacks, so the cached segment is handed out between packets.
+        MT_TRACE_SCOPE("decode reverse segment");
+        AVStream* stream = m_formatcontext->streams[m_videostreamid];
+        int64_t upper = m_reverseupper.count() + (m_formatcontext->start_time != AV_NOPTS_VALUE ? m_formatcontext->start_time : 0);
+        int64_t target = av_rescale_q(upper, AVRational{ 1, 1000000 }, stream->time_base) - 1;
+        if (av_seek_frame(m_formatcontext, m_videostreamid, target, AVSEEK_FLAG_BACKWARD) < 0)
+        {
+            av_seek_frame(m_formatcontext, m_videostreamid, stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0, AVSEEK_FLAG_BACKWARD);
+        }
+        avcodec_flush_buffers(m_videocontext);
+        m_videofilter.Flush();
+        m_videocontext->skip_frame = AVDISCARD_DEFAULT;
+        m_lastreadposition = -1;
+        std::size_t framebytes = GetFrameBytes();
+        std::size_t maxframes = std::max<std::size_t>(1, m_reversecachelimit / 2 / std::max<std::size_t>(framebytes, 1));
+        std::deque<priv::VideoPacketPtr> segment;
+        bool passed = false;
+        bool draining = false;
+        AVPacket packet;
+        while (!passed && m_shouldthreadrun)
+        {
+            av_init_packet(&packet);
+            packet.data = nullptr;
+            packet.size = 0;
+            if (!draining)
+            {
+                auto readstart = std::chrono::steady_clock::now();
+                int readresult = av_read_frame(m_formatcontext, &packet);
+                auto readend = std::chrono::steady_clock::now();
+                m_stats.readtime.Record(readend - readstart);
+                MT_TRACE_EVENT("av_read_frame", readstart, readend);
+                RecordBytesRead();
+                if (readresult < 0) draining = true;
+                else if (packet.stream_index != m_videostreamid)
+                {
+                    av_free_packet(&packet);
+                    continue;
+                }
+            }
+            bool decoded = DecodeVideoPacket(&packet);
+            av_free_packet(&packet);
+            // the playbacks keep draining the segment before this one while it decodes
+            FeedReverseFrames();
+            if (!decoded)
+            {
+                // an empty packet that gives nothing back means the decoder is drained
+                if (draining) break;
+                continue;
+            }
+            ConvertVideoFrame([&](const priv::VideoPacketPtr& VideoPacket)
+            {
+                if (VideoPacket->pts >= m_reverseupper)
+                {
+                    // frames come out in presentation order, everything below the bound is in
+                    passed = true;
+                }
+                else if (!passed)
+                {
+                    segment.push_back(VideoPacket);
+                    if (segment.size() > maxframes) segment.pop_front();
+                }
+            });
+        }
+        if (!m_shouldthreadrun) return;
+        if (segment.empty())
+        {
+            m_reversedone = true;
+            return;
+        }
+        m_reverseupper = segment.front()->pts;
+        while (!segment.empty())
+        {
+            m_reverseframes.push_back(segment.back());
+            segment.pop_back();
+        }
+    }
+
+    void DataSource::FeedReverseFrames()
+    {
+        bool fed = false;
+        std::vector<std::chrono::microseconds> fedpts;
+        {
+            PlaybackListPtr playbacks = GetPlaybacks();
+            while (!m_reverseframes.empty())
+            {
+                bool room = false;
+                for (auto& videoplayback : playbacks->video)
+                {
+                    std::lock_guard<std::mutex> lock(videoplayback->m_protectionlock);
+                    if (videoplayback->m_queuedvideopackets.size() < m_videoqueuedepth) room = true;
+                }
+                if (!room) break;
+                for (auto& videoplayback : playbacks->video)
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(videoplayback->m_protectionlock);
+                        videoplayback->m_queuedvideopackets.push(m_reverseframes.front());
+                        std::size_t queuedepth = videoplayback->m_queuedvideopackets.size();
+                        priv::RaiseHighWater(videoplayback->m_queuehighwater, queuedepth);
+                        priv::RaiseHighWater(m_stats.queuedepthhighwater, queuedepth);
+                    }
+                    videoplayback->m_ready.Signal();
+                }
+                fedpts.push_back(m_reverseframes.front()->pts);
+                m_reverseframes.pop_front();
+                fed = true;
             }
+            if (fed) UpdateDeadline(*playbacks);
         }
+        if (fed)
+        {
+            RecordSeekLatency();
+            WakeReaders();
+        }
+        // same as PushVideoPacket once the list is let go, this also signals the source's ready descriptor
+        for (auto pts : fedpts)
+        {
+            NotifyFrameReady(pts);
+        }
+    }
+
+    bool DataSource::DecodeVideoPacket(AVPacket* Packet)
+    {
+        int decoderesult = 0;
+        auto decodestart = std::chrono::steady_clock::now();
+        int decodelength = avcodec_decode_video2(m_videocontext, m_videorawframe, &decoderesult, Packet);
+        auto decodeend = std::chrono::steady_clock::now();
+        m_stats.decodetime.Record(decodeend - decodestart);
+        MT_TRACE_EVENT("decode video", decodestart, decodeend);
+        if (decodelength < 0 || !decoderesult) return false;
+        priv::IncrementStat(m_stats.decodedvideoframes);
         return true;
     }
 
-    AVFrame* DataSource::CreatePictureFrame(AVPixelFormat SelectedPixelFormat, int Width, int Height, uint8_t*& PictureBuffer)
+    bool DataSource::CreateVideoFilter()
+    {
+        // expects the decoder to be stopped, the graph decides the size of everything after it
+        AVStream* stream = m_formatcontext->streams[m_videostreamid];
+        bool created = m_videofilter.Create(m_videofilterdescription, m_videocontext->width, m_videocontext->height, m_videocontext->pix_fmt, stream->time_base, m_videocontext->sample_aspect_ratio);
+        if (!created)
+        {
+            std::cout << "Motion: Failed to create video filter: '" << m_videofilterdescription << "'" << std::endl;
+            m_videofilter.Destroy();
+        }
+        m_videosize = Vector2(m_videofilter.GetOutputWidth(), m_videofilter.GetOutputHeight());
+        return created;
+    }
+
+    bool DataSource::ConvertVideoFrame(const std::function<void(const priv::VideoPacketPtr& Packet)>& Output)
+    {
+        // a filter graph may hold frames back or hand out several, each one becomes a packet
+        std::size_t produced = 0;
+        auto convertstart = std::chrono::steady_clock::now();
+        int64_t timestamp = av_frame_get_best_effort_timestamp(m_videorawframe);
+        auto accept = [&](std::chrono::microseconds Pts)
+        {
+            // while looping nothing outside the loop goes out, the first frame past its end
+            // starts the next pass and frames the prefetch already covered are skipped
+            bool outside = IsOutsideLoop(Pts);
+            if (outside && Pts.count() >= m_loopstart) m_loopwrap = true;
+            if (!outside && Pts > m_loopskipuntil) return true;
+            m_nextvideopts = Pts + GetVideoFrameTime();
+            return false;
+        };
+        FrameSinkPtr sink;
+        {
+            std::lock_guard<std::mutex> lock(m_sinklock);
+            sink = m_framesink;
+        }
+        auto emit = [&](const priv::VideoPacketPtr& Packet, std::chrono::microseconds Pts)
+        {
+            priv::IncrementStat(m_stats.convertedframes);
+            m_nextvideopts = Pts + GetVideoFrameTime();
+            // over the memory cap the cache keeps what it has but stops growing, later loop passes are shifted past it
+            if (!MemoryGovernor::GetInstance().IsOverLimit() && m_loopshift.count() == 0) m_framecache.Insert(Packet);
+            if (m_loopcapturing)
+            {
+                // the prefetch keeps file timestamps, every pass shifts its own view of the pixels
+                if (m_loopshift.count() == 0) m_loopprefetch.push_back(Packet);
+                else m_loopprefetch.push_back(std::make_shared<priv::VideoPacket>(Packet, Pts));
+                if (m_loopprefetch.size() >= std::max<std::size_t>(m_videoqueuedepth, 1)) m_loopcapturing = false;
+            }
+            produced++;
+            Output(Packet);
+            convertstart = std::chrono::steady_clock::now();
+        };
+        if (m_videofilter.IsActive())
+        {
+            m_videorawframe->pts = timestamp;
+            AVRational streamtimebase = m_formatcontext->streams[m_videostreamid]->time_base;
+            m_videofilter.Process(m_videorawframe, [&](AVFrame* Filtered)
+            {
+                auto pts = Filtered->pts == AV_NOPTS_VALUE ? m_nextvideopts : StreamTimeToOffset(m_videostreamid, av_rescale_q(Filtered->pts, m_videofilter.GetOutputTimeBase(), streamtimebase));
+                if (!accept(pts)) return;
+                auto convertend = std::chrono::steady_clock::now();
+                m_stats.converttime.Record(convertend - convertstart);
+                MT_TRACE_EVENT("filter graph", convertstart, convertend);
+                // the graph owns its output, the region of it is copied once into the packet
+                Rect region = ClampRegion(Filtered->width, Filtered->height, 1, 1);
+                const uint8_t* origin = Filtered->data[0] + region.top * Filtered->linesize[0] + region.left * 4;
+                priv::VideoPacketPtr packet(std::make_shared<priv::VideoPacket>(region.width, region.height, pts + m_loopshift, m_memory, sink, m_rowalignment));
+                for (int y = 0; y < region.height; y++)
+                {
+                    std::memcpy(packet->m_rgbabuffer + y * packet->stride, origin + y * Filtered->linesize[0], region.width * 4);
+                }
+                auto copyend = std::chrono::steady_clock::now();
+                m_stats.decodecopytime.Record(copyend - convertend);
+                MT_TRACE_EVENT("copy video packet", convertend, copyend);
+                emit(packet, pts);
+            });
+            return produced > 0;
+        }
+        auto pts = timestamp == AV_NOPTS_VALUE ? m_nextvideopts : StreamTimeToOffset(m_videostreamid, timestamp);
+        if (!accept(pts)) return false;
+        // only the region of interest is handed to the scaler, the planes start at its corner
+        const AVPixFmtDescriptor* descriptor = av_pix_fmt_desc_get(m_videocontext->pix_fmt);
+        Rect region = ClampRegion(m_videocontext->width, m_videocontext->height, 1 << descriptor->log2_chroma_w, 1 << descriptor->log2_chroma_h);
+        if (region.width != m_convertregion.width || region.height != m_convertregion.height)
+        {
+            int swapmode = SWS_FAST_BILINEAR;
+            if (region.width * region.height <= 500000 && region.width % 8 != 0) swapmode |= SWS_ACCURATE_RND;
+            m_videoswcontext = sws_getCachedContext(m_videoswcontext, region.width, region.height, m_videocontext->pix_fmt, region.width, region.height, AVPixelFormat::AV_PIX_FMT_RGBA, swapmode, nullptr, nullptr, nullptr);
+        }
+        m_convertregion = region;
+        if (!m_videoswcontext) return false;
+        const uint8_t* planes[4] = { nullptr, nullptr, nullptr, nullptr };
+        int pixelsteps[4];
+        av_image_fill_max_pixsteps(pixelsteps, nullptr, descriptor);
+        for (int plane = 0; plane < 4 && m_videorawframe->data[plane]; plane++)
+        {
+            bool chroma = plane == 1 || plane == 2;
+            int x = chroma ? region.left >> descriptor->log2_chroma_w : region.left;
+            int y = chroma ? region.top >> descriptor->log2_chroma_h : region.top;
+            if (plane == 1 && (descriptor->flags & AV_PIX_FMT_FLAG_PAL)) planes[plane] = m_videorawframe->data[plane];
+            else planes[plane] = m_videorawframe->data[plane] + y * m_videorawframe->linesize[plane] + x * pixelsteps[plane];
+        }
+        // the scaler writes straight into the packet, or the frame sink's memory behind it
+        priv::VideoPacketPtr packet(std::make_shared<priv::VideoPacket>(region.width, region.height, pts + m_loopshift, m_memory, sink, m_rowalignment));
+        uint8_t* destination[4] = { packet->m_rgbabuffer, nullptr, nullptr, nullptr };
+        int destinationstride[4] = { packet->stride, 0, 0, 0 };
+        int convertresult = sws_scale(m_videoswcontext, planes, m_videorawframe->linesize, 0, region.height, destination, destinationstride);
+        auto convertend = std::chrono::steady_clock::now();
+        m_stats.converttime.Record(convertend - convertstart);
+        MT_TRACE_EVENT("sws_scale", convertstart, convertend);
+        if (!convertresult) return false;
+        emit(packet, pts);
+        return true;
+    }
+
+    void DataSource::PushVideoPacket(const priv::VideoPacketPtr& Packet)
+    {
+        MT_TRACE_SCOPE("queue push video");
+        m_slicevideoframes++;
+        {
+            PlaybackListPtr playbacks = GetPlaybacks();
+            for (auto& videoplayback : playbacks->video)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(videoplayback->m_protectionlock);
+                    videoplayback->m_queuedvideopackets.push(Packet);
+                    std::size_t queuedepth = videoplayback->m_queuedvideopackets.size();
+                    priv::RaiseHighWater(videoplayback->m_queuehighwater, queuedepth);
+                    priv::RaiseHighWater(m_stats.queuedepthhighwater, queuedepth);
+                }
+                videoplayback->m_ready.Signal();
+            }
+            UpdateDeadline(*playbacks);
+        }
+        WakeReaders();
+        NotifyFrameReady(Packet->pts);
+    }
+
+    void DataSource::PushAudio(const int16_t* Samples, int FrameCount, std::chrono::microseconds Pts, float Tempo)
+    {
+        MT_TRACE_SCOPE("queue push audio");
+        PlaybackListPtr playbacks = GetPlaybacks();
+        for (auto& audioplayback : playbacks->audio)
+        {
+            audioplayback->WriteSamples(Samples, FrameCount, Pts, Tempo);
+        }
+    }
+
+    void DataSource::RecordProduceTime(std::chrono::steady_clock::duration Duration)
+    {
+        // exponentially weighted mean and variance of the time it takes to produce one frame
+        double sample = std::chrono::duration<double, std::micro>(Duration).count();
+        double delta = sample - m_producemean;
+        m_producemean += delta / QUEUE_JITTER_WINDOW;
+        m_producevariance = (1.0 - 1.0 / QUEUE_JITTER_WINDOW) * (m_producevariance + delta * delta / QUEUE_JITTER_WINDOW);
+        UpdateQueueDepth();
+    }
+
+    void DataSource::UpdateQueueDepth()
+    {
+        // runs on the decode thread, or before it is started
+        QueueLimits limits = GetQueueLimits();
+        // a jittery decoder needs enough queued to ride out its slow frames, unless memory is short
+        bool pressure = MemoryGovernor::GetInstance().IsOverLimit();
+        auto jitter = std::chrono::microseconds(static_cast<long long>(std::sqrt(m_producevariance) * QUEUE_JITTER_FACTOR));
+        auto target = std::min(std::max(limits.minduration + jitter, limits.minduration), limits.maxduration);
+        if (pressure) target = limits.minduration;
+        m_queuetarget = target.count();
+        if (HasVideo())
+        {
+            std::size_t framebytes = std::max<std::size_t>(GetFrameBytes(), 1);
+            double frameduration = GetVideoFrameTime().count() / static_cast<double>(m_playbackspeed);
+            std::size_t frames = frameduration > 0 ? static_cast<std::size_t>(std::ceil(target.count() / frameduration)) : limits.minframes;
+            std::size_t depth = pressure ? 0 : std::min(std::min(frames, limits.maxframes), limits.maxbytes / framebytes);
+            m_videoqueuedepth = std::max(depth, std::max<std::size_t>(limits.minframes, 1));
+        }
+        if (HasAudio())
+        {
+            std::size_t framebytes = static_cast<std::size_t>(std::max(m_audiochannelcount, 1)) * sizeof(int16_t);
+            // samples leave the tempo stage at the output rate, so no speed scaling here
+            std::size_t frames = static_cast<std::size_t>(GetAudioSampleRate() * (target.count() / 1000000.0));
+            m_audioqueueframes = std::max<std::size_t>(std::min(frames, limits.maxbytes / framebytes), 1);
+        }
+    }
+
+    const std::string DataSource::GetVideoFilter()
+    {
+        return m_videofilterdescription;
+    }
+
+    bool DataSource::SetVideoFilter(const std::string& Description)
+    {
+        std::string previous = m_videofilterdescription;
+        m_videofilterdescription = Description;
+        if (!HasVideo()) return true;
+        StopDecodeThread();
+        m_loopprefetch.clear();
+        bool created = CreateVideoFilter();
+        if (!created)
+        {
+            m_videofilterdescription = previous;
+            CreateVideoFilter();
+        }
+        // what is queued and cached went through the old graph, decode the current position again
+        m_framecache.Clear();
+        UpdateQueueDepth();
+        Seek(GetPlayingOffset());
+        return created;
+    }
+
+    const QueueLimits DataSource::GetQueueLimits()
+    {
+        std::lock_guard<std::mutex> lock(m_limitslock);
+        return m_queuelimits;
+    }
+
+    void DataSource::SetQueueLimits(const QueueLimits& Limits)
+    {
+        std::lock_guard<std::mutex> lock(m_limitslock);
+        m_queuelimits = Limits;
+    }
+
+    bool DataSource::IsFull()
+    {
+        // over the memory cap low priority sources stop decoding altogether
+        if (m_priority == DecodePriority::Low && MemoryGovernor::GetInstance().IsOverLimit()) return true;
+        // each stream is judged on its own queues, a stream with room keeps the demuxer going
+        // unless everything left for it is parked or the parking space is used up
+        bool canread = !m_demuxeof && m_parkedbytes < GetQueueLimits().maxparkedbytes;
+        PlaybackListPtr playbacks = GetPlaybacks();
+        if (HasVideo() && HasRoom(*playbacks, m_videostreamid) && (canread || !m_parkedvideo.empty() || m_looppending > 0)) return false;
+        if (HasAudio() && HasRoom(*playbacks, m_audiostreamid) && (canread || !m_parkedaudio.empty())) return false;
+        return true;
+    }
+
+    bool DataSource::HasRoom(const PlaybackList& Playbacks, int StreamId)
+    {
+        if (StreamId < 0) return false;
+        if (StreamId == m_videostreamid)
+        {
+            for (auto& videoplayback : Playbacks.video)
+            {
+                std::lock_guard<std::mutex> lock(videoplayback->m_protectionlock);
+                if (videoplayback->m_queuedvideopackets.size() < m_videoqueuedepth) return true;
+            }
+        }
+        else if (StreamId == m_audiostreamid)
+        {
+            // every playback gets the same samples, one that is full would have to hold them back
+            for (auto& audioplayback : Playbacks.audio)
+            {
+                if (audioplayback->IsBufferFull()) return false;
+            }
+            return !Playbacks.audio.empty();
+        }
+        return false;
+    }
+
+    bool DataSource::HasConsumers(const PlaybackList& Playbacks, int StreamId)
+    {
+        if (StreamId < 0) return false;
+        if (StreamId == m_videostreamid) return !Playbacks.video.empty();
+        if (StreamId == m_audiostreamid) return !Playbacks.audio.empty();
+        return false;
+    }
+
+    void DataSource::RecordBytesRead()
+    {
+        // counts what the demuxer pulled off the underlying io, position jumps from seeking are not counted
+        if (!m_formatcontext->pb) return;
+        int64_t position = avio_tell(m_formatcontext->pb);
+        if (m_lastreadposition >= 0 && position > m_lastreadposition)
+        {
+            priv::IncrementStat(m_stats.bytesread, static_cast<uint64_t>(position - m_lastreadposition));
+        }
+        m_lastreadposition = position;
+    }
+
+    void DataSource::RecordSeekLatency()
+    {
+        if (m_seekpending.exchange(false))
+        {
+            m_stats.seeklatency.Record(std::chrono::steady_clock::now() - m_seekstart);
+        }
+    }
+
+    std::chrono::microseconds DataSource::StreamTimeToOffset(int StreamId, int64_t Timestamp)
+    {
+        // both streams are measured from the container start so they stay comparable
+        int64_t offset = av_rescale_q(Timestamp, m_formatcontext->streams[StreamId]->time_base, AVRational{ 1, 1000000 });
+        if (m_formatcontext->start_time != AV_NOPTS_VALUE) offset -= m_formatcontext->start_time;
+        return std::chrono::microseconds(offset);
+    }
+
+    std::chrono::microseconds DataSource::SyncAudioTimestamp(int64_t Timestamp, int SampleCount)
+    {
+        // decode thread only.  Audio is timed by counting the samples produced since the last
+        // anchor, when the stream timestamps run away from that count the resampler is asked
+        // to stretch or squeeze the next chunk by up to a few percent instead of dropping or
+        // inserting whole samples.  Returns the time of the first sample of this chunk.
+        int samplerate = m_audiocontext->sample_rate;
+        if (Timestamp != AV_NOPTS_VALUE)
+        {
+            auto pts = StreamTimeToOffset(m_audiostreamid, Timestamp);
+            if (m_audiosynced)
+            {
+                auto expected = m_audioanchorpts + std::chrono::microseconds(m_audiosamplecount * 1000000 / samplerate);
+                auto drift = pts - expected;
+                m_stats.audiodrift.store(drift.count(), std::memory_order_relaxed);
+                if (std::abs(drift.count()) >= AUDIO_RESYNC_THRESHOLD_US)
+                {
+                    // a jump in the stream rather than drift, start counting again from here
+                    m_audiosynced = false;
+                    priv::IncrementStat(m_stats.audioresyncs);
+                }
+                else if (std::abs(drift.count()) >= AUDIO_DRIFT_THRESHOLD_US)
+                {
+                    int limit = SampleCount * AUDIO_MAX_COMPENSATION_PERCENT / 100;
+                    int delta = static_cast<int>(drift.count() * samplerate / 1000000);
+                    delta = std::max(-limit, std::min(limit, delta));
+                    if (delta != 0 && swr_set_compensation(m_audioswcontext, delta, SampleCount) >= 0)
+                    {
+                        priv::IncrementStat(m_stats.audiodriftcorrections);
+                    }
+                }
+            }
+            if (!m_audiosynced)
+            {
+                m_audiosynced = true;
+                m_audioanchorpts = pts;
+                m_audiosamplecount = 0;
+            }
+        }
+        else if (!m_audiosynced)
+        {
+            // untimed stream, trust the sample count from wherever we were seeked to
+            m_audiosynced = true;
+            m_audiosamplecount = 0;
+        }
+        return m_audioanchorpts + std::chrono::microseconds(m_audiosamplecount * 1000000 / samplerate);
+    }
+
+    bool DataSource::IsBehind()
+    {
+        long long deadline = m_nextdeadline;
+        if (deadline == NO_DEADLINE) return false;
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count() >= deadline;
+    }
+
+    void DataSource::UpdateDeadline(const PlaybackList& Playbacks)
+    {
+        // the deadline is when the emptiest playback runs dry, without video playbacks nothing is due
+        auto now = std::chrono::steady_clock::now();
+        auto deadline = now;
+        bool first = true;
+        for (auto& videoplayback : Playbacks.video)
+        {
+            std::lock_guard<std::mutex> lock(videoplayback->m_protectionlock);
+            auto queuedtime = videoplayback->m_frametime * videoplayback->m_queuedvideopackets.size();
+            auto playbackdeadline = now + std::chrono::microseconds(static_cast<long long>(queuedtime.count() / m_playbackspeed));
+            if (first || playbackdeadline < deadline) deadline = playbackdeadline;
+            first = false;
+        }
+        if (first) m_nextdeadline = NO_DEADLINE;
+        else m_nextdeadline = std::chrono::duration_cast<std::chrono::microseconds>(deadline.time_since_epoch()).count();
+    }
+
+    AVFrame* DataSource::CreatePictureFrame(AVPixelFormat SelectedPixelFormat, int Width, int Height, uint8_t*& PictureBuffer, std::size_t& PictureBufferSize)
     {
         AVFrame *picture;
         picture = av_frame_alloc();
@@ -592,20 +1967,340 @@ namespace mt
             av_frame_free(&picture);
             return nullptr;
         }
+        // the decoder resets the frame's own fields, so the charged size is kept by the caller
+        PictureBufferSize = static_cast<std::size_t>(size);
+        m_memory->Charge(MemoryCategory::Staging, PictureBufferSize);
         avpicture_fill((AVPicture*)picture, PictureBuffer, SelectedPixelFormat, Width, Height);
         return picture;
     }
 
-    void DataSource::DestroyPictureFrame(AVFrame*& PictureFrame, uint8_t*& PictureBuffer)
+    void DataSource::DestroyPictureFrame(AVFrame*& PictureFrame, uint8_t*& PictureBuffer, std::size_t& PictureBufferSize)
     {
+        m_memory->Release(MemoryCategory::Staging, PictureBufferSize);
         av_free(PictureBuffer);
         av_frame_free(&PictureFrame);
         PictureBuffer = nullptr;
         PictureFrame = nullptr;
+        PictureBufferSize = 0;
     }
 
     const bool DataSource::IsEndofFileReached()
     {
         return m_eofreached;
     }
+
+    const PlaybackDirection DataSource::GetPlaybackDirection()
+    {
+        return m_direction;
+    }
+
+    void DataSource::SetPlaybackDirection(PlaybackDirection Direction)
+    {
+        if (m_direction == Direction || !HasVideo()) return;
+        // both directions start over from the frame on screen, Seek resets either decoder state
+        m_direction = Direction;
+        Seek(GetStepOrigin(Direction));
+    }
+
+    std::chrono::microseconds DataSource::GetStepOrigin(PlaybackDirection Direction)
+    {
+        // reverse decodes everything below its origin, forward everything from it on
+        PlaybackListPtr playbacks = GetPlaybacks();
+        if (playbacks->video.size() > 0)
+        {
+            std::lock_guard<std::mutex> lock(playbacks->video.front()->m_protectionlock);
+            auto lastpts = playbacks->video.front()->m_lastpts;
+            if (lastpts != std::chrono::microseconds::min())
+            {
+                lastpts = MapLoopOffset(lastpts);
+                return Direction == PlaybackDirection::Forward ? lastpts + std::chrono::microseconds(1) : lastpts;
+            }
+        }
+        return MapLoopOffset(m_playingoffset);
+    }
+
+    const std::size_t DataSource::GetReverseCacheLimit()
+    {
+        return m_reversecachelimit;
+    }
+
+    void DataSource::SetReverseCacheLimit(std::size_t Bytes)
+    {
+        m_reversecachelimit = Bytes;
+    }
+
+    bool DataSource::StepForward()
+    {
+        return StepFrame(PlaybackDirection::Forward);
+    }
+
+    bool DataSource::StepBackward()
+    {
+        return StepFrame(PlaybackDirection::Reverse);
+    }
+
+    bool DataSource::StepFrame(PlaybackDirection Direction)
+    {
+        if (!HasVideo()) return false;
+        Pause();
+        bool reverse = Direction == PlaybackDirection::Reverse;
+        // frames the decoder already queued this way are the cheapest, then the frame cache, then decoding
+        if (m_direction != Direction || m_seekdeferred || !HasQueuedStep(reverse))
+        {
+            if (StepCachedFrame(reverse)) return true;
+            if (m_direction != Direction) SetPlaybackDirection(Direction);
+            else if (m_seekdeferred) Seek(GetStepOrigin(Direction));
+        }
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(STEP_TIMEOUT_MS);
+        std::vector<priv::VideoConsumerPtr> pending = GetPlaybacks()->video;
+        while (true)
+        {
+            {
+                PlaybackListPtr playbacks = GetPlaybacks();
+                for (auto& videoplayback : playbacks->video)
+                {
+                    auto waiting = std::find(pending.begin(), pending.end(), videoplayback);
+                    if (waiting != pending.end() && videoplayback->StepPast(m_playingoffset, reverse))
+                    {
+                        pending.erase(waiting);
+                        m_playingoffset = videoplayback->m_lastpts;
+                    }
+                }
+                // playbacks that went away meanwhile are not waited for
+                pending.erase(std::remove_if(pending.begin(), pending.end(), [&](const priv::VideoConsumerPtr& Consumer)
+                {
+                    return std::find(playbacks->video.begin(), playbacks->video.end(), Consumer) == playbacks->video.end();
+                }), pending.end());
+                UpdateDeadline(*playbacks);
+            }
+            RequestDecode();
+            if (pending.empty()) return true;
+            if (m_playingtoeof || std::chrono::steady_clock::now() > deadline) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    bool DataSource::HasQueuedStep(bool Reverse)
+    {
+        // queues are ordered in the decode direction, so the newest entry is the furthest one
+        PlaybackListPtr playbacks = GetPlaybacks();
+        for (auto& videoplayback : playbacks->video)
+        {
+            std::lock_guard<std::mutex> lock(videoplayback->m_protectionlock);
+            if (videoplayback->m_queuedvideopackets.size() == 0) return false;
+            auto lastpts = videoplayback->m_lastpts;
+            if (lastpts == std::chrono::microseconds::min()) continue;
+            auto newest = videoplayback->m_queuedvideopackets.back()->pts;
+            if (Reverse ? newest >= lastpts : newest <= lastpts) return false;
+        }
+        return playbacks->video.size() > 0;
+    }
+
+    bool DataSource::StepCachedFrame(bool Reverse)
+    {
+        if (m_framecache.GetLimit() == 0) return false;
+        {
+            PlaybackListPtr playbacks = GetPlaybacks();
+            if (playbacks->video.size() == 0) return false;
+            auto lastpts = std::chrono::microseconds::min();
+            {
+                std::lock_guard<std::mutex> lock(playbacks->video.front()->m_protectionlock);
+                lastpts = playbacks->video.front()->m_lastpts;
+            }
+            if (lastpts == std::chrono::microseconds::min()) return false;
+            auto tolerance = GetVideoFrameTime() * 3 / 2;
+            auto packet = Reverse ? m_framecache.FindPrevious(lastpts, tolerance) : m_framecache.FindNext(lastpts, tolerance);
+            if (!packet)
+            {
+                priv::IncrementStat(m_stats.framecachemisses);
+                return false;
+            }
+            priv::IncrementStat(m_stats.framecachehits);
+            for (auto& videoplayback : playbacks->video)
+            {
+                std::lock_guard<std::mutex> lock(videoplayback->m_protectionlock);
+                videoplayback->Present(packet);
+                videoplayback->m_nextdue = std::chrono::microseconds::max();
+            }
+            m_playingoffset = packet->pts;
+        }
+        // stepping against the decoder leaves it behind, it has to seek before it is used again
+        if (Reverse != (m_direction == PlaybackDirection::Reverse))
+        {
+            StopDecodeThread();
+            m_seekdeferred = true;
+        }
+        return true;
+    }
+
+    bool DataSource::PresentCachedFrame(std::chrono::microseconds PlayingOffset)
+    {
+        if (!HasVideo() || m_framecache.GetLimit() == 0) return false;
+        auto packet = m_framecache.FindAt(PlayingOffset, GetVideoFrameTime());
+        if (!packet)
+        {
+            priv::IncrementStat(m_stats.framecachemisses);
+            return false;
+        }
+        priv::IncrementStat(m_stats.framecachehits);
+        // same state changes as a real seek, only the decoder is left parked until playback resumes
+        StopDecodeThread();
+        if (m_state != State::Stopped)
+        {
+            m_eofreached = true;
+            SetState(State::Stopped);
+            m_eofreached = false;
+        }
+        m_playingoffset = PlayingOffset;
+        m_playingtoeof = false;
+        m_seekdeferred = true;
+        PlaybackListPtr playbacks = GetPlaybacks();
+        for (auto& videoplayback : playbacks->video)
+        {
+            std::lock_guard<std::mutex> lock(videoplayback->m_protectionlock);
+            videoplayback->Present(packet);
+        }
+        // let go of the list first, it would otherwise keep playbacks the callback detaches alive
+        playbacks = nullptr;
+        NotifyFrameReady(packet->pts);
+        return true;
+    }
+
+    const bool DataSource::IsLooping()
+    {
+        return m_looping;
+    }
+
+    void DataSource::SetLooping(bool Looping)
+    {
+        if (m_looping == Looping) return;
+        SetLoopRange(GetLoopStart(), GetLoopEnd(), Looping);
+    }
+
+    const std::chrono::microseconds DataSource::GetLoopStart()
+    {
+        return std::chrono::microseconds(m_loopstart.load());
+    }
+
+    const std::chrono::microseconds DataSource::GetLoopEnd()
+    {
+        return std::chrono::microseconds(m_loopend.load());
+    }
+
+    void DataSource::SetLoopRange(std::chrono::microseconds Start, std::chrono::microseconds End)
+    {
+        SetLoopRange(Start, End, m_looping);
+    }
+
+    void DataSource::SetLoopRange(std::chrono::microseconds Start, std::chrono::microseconds End, bool Looping)
+    {
+        if (Start.count() < 0 || (End.count() != 0 && End <= Start))
+        {
+            std::cout << "Motion: Invalid loop range" << std::endl;
+            return;
+        }
+        // the offset is still folded with the old loop, the new timeline starts over from it
+        auto offset = GetPlayingOffset();
+        if (Looping && (offset < Start || (End.count() != 0 && offset >= End))) offset = Start;
+        // a range change while not looping leaves the decoder alone
+        bool restart = (HasVideo() || HasAudio()) && (Looping || m_looping);
+        if (restart)
+        {
+            StopDecodeThread();
+            m_loopprefetch.clear();
+        }
+        m_loopstart = Start.count();
+        m_loopend = End.count();
+        m_looping = Looping;
+        if (restart) Seek(offset);
+    }
+
+    const std::size_t DataSource::GetFrameCacheLimit()
+    {
+        return m_framecache.GetLimit();
+    }
+
+    void DataSource::SetFrameCacheLimit(std::size_t Bytes)
+    {
+        m_framecache.SetLimit(Bytes);
+    }
+
+    const DecodeMode DataSource::GetDecodeMode()
+    {
+        return m_decodemode;
+    }
+
+    void DataSource::SetDecodeMode(DecodeMode Mode)
+    {
+        if (m_decodemode == Mode) return;
+        bool wasrunning = m_shouldthreadrun;
+        StopDecodeThread();
+        m_decodemode = Mode;
+        if (wasrunning) StartDecodeThread();
+    }
+
+    const DecodePriority DataSource::GetPriority()
+    {
+        return m_priority;
+    }
+
+    void DataSource::SetPriority(DecodePriority Priority)
+    {
+        m_priority = Priority;
+    }
+
+    const std::chrono::steady_clock::time_point DataSource::GetNextDeadline()
+    {
+        long long deadline = m_nextdeadline;
+        if (deadline == NO_DEADLINE) return std::chrono::steady_clock::time_point::max();
+        return std::chrono::steady_clock::time_point(std::chrono::microseconds(deadline));
+    }
+
+    const unsigned int DataSource::GetDeadlineMissCount()
+    {
+        return m_deadlinemisscount;
+    }
+
+    const DataSourceStats DataSource::GetStats()
+    {
+        DataSourceStats stats;
+        m_stats.Fill(stats);
+        stats.deadlinemisses = m_deadlinemisscount;
+        stats.framecachebytes = m_framecache.GetBytes();
+        stats.videoqueuelimit = m_videoqueuedepth;
+        stats.audioqueuelimit = m_audioqueueframes;
+        stats.queuetarget = std::chrono::microseconds(m_queuetarget.load());
+        stats.stagingbytes = m_memory->GetBytes(MemoryCategory::Staging);
+        std::size_t framebytes = HasVideo() ? GetFrameBytes() : 0;
+        {
+            // queued frames are shared between the playbacks, the longest queue holds them all
+            PlaybackListPtr playbacks = GetPlaybacks();
+            std::size_t queued = 0;
+            for (auto& videoplayback : playbacks->video)
+            {
+                std::lock_guard<std::mutex> lock(videoplayback->m_protectionlock);
+                queued = std::max(queued, videoplayback->m_queuedvideopackets.size());
+            }
+            stats.videoqueuebytes = queued * framebytes;
+            for (auto& audioplayback : playbacks->audio)
+            {
+                stats.audioqueuebytes += audioplayback->m_samples.GetReadAvailable() * sizeof(int16_t);
+            }
+        }
+        stats.parkedpackets = m_parkedcount;
+        stats.parkedbytes = m_parkedbytes;
+        stats.memorybytes = m_memory->GetTotalBytes();
+        return stats;
+    }
+
+    void DataSource::ResetStats()
+    {
+        m_stats.Reset();
+        m_deadlinemisscount = 0;
+        PlaybackListPtr playbacks = GetPlaybacks();
+        for (auto& videoplayback : playbacks->video)
+        {
+            videoplayback->ResetStats();
+        }
+    }
 }
\ No newline at end of file
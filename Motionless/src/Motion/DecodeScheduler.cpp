@@ -0,0 +1,238 @@
+#pragma once
+
+#include "include/DecodeScheduler.hpp"
+#include "include/DataSource.hpp"
+#include "include/priv/TraceScope.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#define SCHEDULER_SLICE_FRAMES 2
+#define SCHEDULER_MAX_PASSES 8
+
+namespace mt
+{
+    namespace
+    {
+        enum TaskState
+        {
+            TaskIdle,
+            TaskQueued,
+            TaskRunning,
+            TaskRunningDirty
+        };
+
+        thread_local std::size_t t_workerindex = std::numeric_limits<std::size_t>::max();
+    }
+
+    DecodeScheduler::DecodeScheduler() :
+        m_workers(),
+        m_threads(),
+        m_waitlock(),
+        m_waitcondition(),
+        m_shouldrun(true),
+        m_nextworker(0),
+        m_pendingcount(0)
+    {
+        std::size_t workercount = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+        for (std::size_t i = 0; i < workercount; i++)
+        {
+            m_workers.push_back(std::make_unique<Worker>());
+        }
+        for (std::size_t i = 0; i < workercount; i++)
+        {
+            m_threads.emplace_back(&DecodeScheduler::WorkerRun, this, i);
+        }
+    }
+
+    DecodeScheduler::~DecodeScheduler()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_waitlock);
+            m_shouldrun = false;
+        }
+        m_waitcondition.notify_all();
+        for (auto& thread : m_threads)
+        {
+            if (thread.joinable()) thread.join();
+        }
+    }
+
+    DecodeScheduler& DecodeScheduler::GetInstance()
+    {
+        static DecodeScheduler instance;
+        return instance;
+    }
+
+    const std::size_t DecodeScheduler::GetWorkerCount()
+    {
+        return m_workers.size();
+    }
+
+    void DecodeScheduler::Submit(DataSource* Source)
+    {
+        while (true)
+        {
+            int state = Source->m_taskstate.load();
+            if (state == TaskQueued || state == TaskRunningDirty)
+            {
+                return;
+            }
+            else if (state == TaskRunning)
+            {
+                // the running worker requeues the source once its current slice is done
+                if (Source->m_taskstate.compare_exchange_weak(state, TaskRunningDirty)) return;
+            }
+            else if (Source->m_taskstate.compare_exchange_weak(state, TaskQueued))
+            {
+                std::size_t workerindex = t_workerindex;
+                if (workerindex >= m_workers.size()) workerindex = m_nextworker++ % m_workers.size();
+                Enqueue(workerindex, Source);
+                return;
+            }
+        }
+    }
+
+    void DecodeScheduler::Cancel(DataSource* Source)
+    {
+        // the caller has already cleared m_shouldthreadrun, so a worker that still holds the
+        // source will bail out of its slice and mark it idle
+        if (RemoveQueued(Source)) Source->m_taskstate = TaskIdle;
+        while (Source->m_taskstate.load() != TaskIdle)
+        {
+            std::this_thread::yield();
+        }
+        if (RemoveQueued(Source)) Source->m_taskstate = TaskIdle;
+    }
+
+    bool DecodeScheduler::RemoveQueued(DataSource* Source)
+    {
+        bool removed = false;
+        for (auto& worker : m_workers)
+        {
+            std::lock_guard<std::mutex> lock(worker->lock);
+            auto end = std::remove(worker->tasks.begin(), worker->tasks.end(), Source);
+            std::size_t count = std::distance(end, worker->tasks.end());
+            if (count > 0)
+            {
+                worker->tasks.erase(end, worker->tasks.end());
+                m_pendingcount -= count;
+                removed = true;
+            }
+        }
+        return removed;
+    }
+
+    void DecodeScheduler::Enqueue(std::size_t WorkerIndex, DataSource* Source)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_workers[WorkerIndex]->lock);
+            m_workers[WorkerIndex]->tasks.push_back(Source);
+            m_pendingcount++;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_waitlock);
+        }
+        m_waitcondition.notify_one();
+    }
+
+    bool DecodeScheduler::IsMoreUrgent(DataSource* Source, DataSource* Other)
+    {
+        // a source that was passed over too often goes first whatever its priority, so a steady
+        // stream of urgent work cannot starve low priority sources
+        bool starved = Source->m_schedulerpasses >= SCHEDULER_MAX_PASSES;
+        bool otherstarved = Other->m_schedulerpasses >= SCHEDULER_MAX_PASSES;
+        if (starved != otherstarved) return starved;
+        if (starved) return Source->m_schedulerpasses > Other->m_schedulerpasses;
+        DecodePriority priority = Source->m_priority;
+        DecodePriority otherpriority = Other->m_priority;
+        if (priority != otherpriority) return priority > otherpriority;
+        return Source->m_nextdeadline.load() < Other->m_nextdeadline.load();
+    }
+
+    bool DecodeScheduler::TryPop(std::size_t WorkerIndex, DataSource*& Source)
+    {
+        // urgency is compared across every worker's queue, not just this one's, so a high priority
+        // or nearly due source queued elsewhere is not held up behind local low priority work.
+        // The locks are always taken in index order, nothing else holds more than one of them.
+        std::vector<std::unique_lock<std::mutex>> locks;
+        locks.reserve(m_workers.size());
+        for (auto& worker : m_workers)
+        {
+            locks.emplace_back(worker->lock);
+        }
+        Worker* mosturgentworker = nullptr;
+        std::deque<DataSource*>::iterator mosturgent;
+        for (std::size_t i = 0; i < m_workers.size(); i++)
+        {
+            // scanning from our own queue first keeps ties local
+            Worker& worker = *m_workers[(WorkerIndex + i) % m_workers.size()];
+            for (auto task = worker.tasks.begin(); task != worker.tasks.end(); ++task)
+            {
+                if (!mosturgentworker || IsMoreUrgent(*task, *mosturgent))
+                {
+                    mosturgentworker = &worker;
+                    mosturgent = task;
+                }
+            }
+        }
+        if (!mosturgentworker) return false;
+        Source = *mosturgent;
+        for (auto& worker : m_workers)
+        {
+            for (auto task : worker->tasks)
+            {
+                if (task != Source) task->m_schedulerpasses++;
+            }
+        }
+        Source->m_schedulerpasses = 0;
+        mosturgentworker->tasks.erase(mosturgent);
+        m_pendingcount--;
+        return true;
+    }
+
+    void DecodeScheduler::WorkerRun(std::size_t WorkerIndex)
+    {
+        t_workerindex = WorkerIndex;
+        MT_TRACE_THREAD_NAME("Motion decode worker");
+        while (m_shouldrun)
+        {
+            DataSource* source = nullptr;
+            if (!TryPop(WorkerIndex, source))
+            {
+                std::unique_lock<std::mutex> lock(m_waitlock);
+                m_waitcondition.wait(lock, [this]() { return !m_shouldrun || m_pendingcount > 0; });
+                continue;
+            }
+            if (!source->m_shouldthreadrun)
+            {
+                source->m_taskstate = TaskIdle;
+                continue;
+            }
+            source->m_taskstate = TaskRunning;
+            bool more = false;
+            {
+                MT_TRACE_SCOPE("decode slice");
+                more = source->DecodeSlice(SCHEDULER_SLICE_FRAMES);
+            }
+            if (!source->m_shouldthreadrun)
+            {
+                source->m_taskstate = TaskIdle;
+            }
+            else if (more)
+            {
+                source->m_taskstate = TaskQueued;
+                Enqueue(WorkerIndex, source);
+            }
+            else
+            {
+                int state = TaskRunning;
+                if (!source->m_taskstate.compare_exchange_strong(state, TaskIdle))
+                {
+                    source->m_taskstate = TaskQueued;
+                    Enqueue(WorkerIndex, source);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "include/priv/FrameCache.hpp"
+
+namespace mt
+{
+    namespace priv
+    {
+        FrameCache::FrameCache() :
+            m_lock(),
+            m_entries(),
+            m_recent(),
+            m_bytes(0),
+            m_limit(0)
+        { }
+
+        std::size_t FrameCache::GetPacketBytes(const VideoPacketPtr& Packet)
+        {
+            return static_cast<std::size_t>(Packet->stride) * Packet->height;
+        }
+
+        void FrameCache::Insert(const VideoPacketPtr& Packet)
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            std::size_t bytes = GetPacketBytes(Packet);
+            if (bytes > m_limit) return;
+            int64_t key = Packet->pts.count();
+            auto found = m_entries.find(key);
+            if (found != m_entries.end())
+            {
+                m_bytes -= GetPacketBytes(found->second.packet);
+                found->second.packet = Packet;
+                m_recent.splice(m_recent.begin(), m_recent, found->second.recent);
+            }
+            else
+            {
+                m_recent.push_front(key);
+                m_entries[key] = Entry{ Packet, m_recent.begin() };
+            }
+            m_bytes += bytes;
+            Evict();
+        }
+
+        VideoPacketPtr FrameCache::Touch(std::map<int64_t, Entry>::iterator Found)
+        {
+            // expects m_lock to be held
+            m_recent.splice(m_recent.begin(), m_recent, Found->second.recent);
+            return Found->second.packet;
+        }
+
+        void FrameCache::Evict()
+        {
+            // expects m_lock to be held
+            while (m_bytes > m_limit && !m_recent.empty())
+            {
+                auto found = m_entries.find(m_recent.back());
+                m_bytes -= GetPacketBytes(found->second.packet);
+                m_entries.erase(found);
+                m_recent.pop_back();
+            }
+        }
+
+        VideoPacketPtr FrameCache::FindAt(std::chrono::microseconds Position, std::chrono::microseconds Tolerance)
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            auto found = m_entries.upper_bound(Position.count());
+            if (found == m_entries.begin()) return nullptr;
+            --found;
+            if (Position.count() - found->first >= Tolerance.count()) return nullptr;
+            return Touch(found);
+        }
+
+        VideoPacketPtr FrameCache::FindNext(std::chrono::microseconds Pts, std::chrono::microseconds Tolerance)
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            auto found = m_entries.upper_bound(Pts.count());
+            if (found == m_entries.end() || found->first - Pts.count() > Tolerance.count()) return nullptr;
+            return Touch(found);
+        }
+
+        VideoPacketPtr FrameCache::FindPrevious(std::chrono::microseconds Pts, std::chrono::microseconds Tolerance)
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            auto found = m_entries.lower_bound(Pts.count());
+            if (found == m_entries.begin()) return nullptr;
+            --found;
+            if (Pts.count() - found->first > Tolerance.count()) return nullptr;
+            return Touch(found);
+        }
+
+        void FrameCache::Clear()
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_entries.clear();
+            m_recent.clear();
+            m_bytes = 0;
+        }
+
+        std::size_t FrameCache::GetBytes()
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            return m_bytes;
+        }
+
+        std::size_t FrameCache::GetLimit()
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            return m_limit;
+        }
+
+        void FrameCache::SetLimit(std::size_t Bytes)
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_limit = Bytes;
+            Evict();
+        }
+    }
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "include/FrameReader.hpp"
+#include "include/priv/TraceScope.hpp"
+
+namespace mt
+{
+    FrameReader::Iterator::Iterator() :
+        m_reader(nullptr),
+        m_frame()
+    { }
+
+    FrameReader::Iterator::Iterator(FrameReader& Reader) :
+        m_reader(&Reader),
+        m_frame(Reader.NextFrame())
+    { }
+
+    FrameReader::Iterator::reference FrameReader::Iterator::operator*() const
+    {
+        return m_frame;
+    }
+
+    FrameReader::Iterator::pointer FrameReader::Iterator::operator->() const
+    {
+        return &m_frame;
+    }
+
+    FrameReader::Iterator& FrameReader::Iterator::operator++()
+    {
+        m_frame = m_reader ? m_reader->NextFrame() : nullptr;
+        return *this;
+    }
+
+    bool FrameReader::Iterator::operator==(const Iterator& Other) const
+    {
+        // every iterator past the last frame is the end iterator
+        return m_frame == Other.m_frame;
+    }
+
+    bool FrameReader::Iterator::operator!=(const Iterator& Other) const
+    {
+        return !(*this == Other);
+    }
+
+    FrameReader::FrameReader(DataSource& DataSource) :
+        m_playback(DataSource)
+    {
+        m_playback.m_consumer->m_offline = true;
+        DataSource.m_offlinereaders++;
+        DataSource.RequestDecode();
+    }
+
+    FrameReader::~FrameReader()
+    {
+        priv::VideoConsumer& consumer = *m_playback.m_consumer;
+        {
+            // the consumer outlives the reader while the decoder still holds it, nothing may complete after this
+            std::lock_guard<std::mutex> asynclock(consumer.m_asynclock);
+            consumer.m_pendingcallback = nullptr;
+            consumer.m_pendingexecutor = nullptr;
+        }
+        // the source clears m_datasource when it goes away first
+        if (consumer.m_datasource) consumer.m_datasource->m_offlinereaders--;
+    }
+
+    priv::VideoPacketPtr FrameReader::NextFrame()
+    {
+        priv::VideoConsumer& consumer = *m_playback.m_consumer;
+        DataSource* datasource = consumer.m_datasource;
+        priv::VideoPacketPtr frame;
+        {
+            std::unique_lock<std::mutex> lock(consumer.m_protectionlock);
+            while (!consumer.TakeFrame(frame))
+            {
+                // the timeout covers a decoder that went idle on a full queue before this one drained
+                lock.unlock();
+                datasource->RequestDecode();
+                lock.lock();
+                MT_TRACE_SCOPE("reader wait");
+                consumer.m_framequeued.wait_for(lock, std::chrono::milliseconds(20));
+            }
+        }
+        // room in the queue again, let the decoder refill it right away
+        if (frame) datasource->RequestDecode();
+        return frame;
+    }
+
+    bool FrameReader::TryNextFrame(priv::VideoPacketPtr& Frame)
+    {
+        priv::VideoConsumer& consumer = *m_playback.m_consumer;
+        bool taken;
+        {
+            std::lock_guard<std::mutex> lock(consumer.m_protectionlock);
+            taken = consumer.TakeFrame(Frame);
+        }
+        if (consumer.m_datasource) consumer.m_datasource->RequestDecode();
+        return taken;
+    }
+
+    void FrameReader::RequestNextFrame(FrameCallback Callback, Executor Executor)
+    {
+        priv::VideoConsumer& consumer = *m_playback.m_consumer;
+        std::function<void()> task;
+        {
+            std::lock_guard<std::mutex> asynclock(consumer.m_asynclock);
+            priv::VideoPacketPtr frame;
+            bool taken;
+            {
+                std::lock_guard<std::mutex> lock(consumer.m_protectionlock);
+                taken = consumer.TakeFrame(frame);
+            }
+            if (taken)
+            {
+                task = priv::VideoConsumer::MakeTask(std::move(Callback), std::move(Executor), std::move(frame));
+            }
+            else
+            {
+                // completed by the decoder through DataSource::WakeReaders
+                consumer.m_pendingcallback = std::move(Callback);
+                consumer.m_pendingexecutor = std::move(Executor);
+            }
+        }
+        if (consumer.m_datasource) consumer.m_datasource->RequestDecode();
+        if (task) task();
+    }
+
+    FrameReader::Iterator FrameReader::begin()
+    {
+        return Iterator(*this);
+    }
+
+    FrameReader::Iterator FrameReader::end()
+    {
+        return Iterator();
+    }
+
+    const uint64_t FrameReader::GetReadFrameCount()
+    {
+        return m_playback.m_consumer->m_presentedframecount;
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "include/priv/MemoryAccount.hpp"
+#include "include/MemoryGovernor.hpp"
+
+namespace mt
+{
+    namespace priv
+    {
+        MemoryAccount::MemoryAccount(const DataSource* Source) :
+            m_source(Source)
+        {
+            for (auto& bytes : m_bytes)
+            {
+                bytes.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        void MemoryAccount::Charge(MemoryCategory Category, std::size_t Bytes)
+        {
+            m_bytes[static_cast<std::size_t>(Category)].fetch_add(Bytes, std::memory_order_relaxed);
+            MemoryGovernor::GetInstance().m_used.fetch_add(Bytes, std::memory_order_relaxed);
+        }
+
+        void MemoryAccount::Release(MemoryCategory Category, std::size_t Bytes)
+        {
+            m_bytes[static_cast<std::size_t>(Category)].fetch_sub(Bytes, std::memory_order_relaxed);
+            MemoryGovernor::GetInstance().m_used.fetch_sub(Bytes, std::memory_order_relaxed);
+        }
+
+        const std::size_t MemoryAccount::GetBytes(MemoryCategory Category)
+        {
+            return m_bytes[static_cast<std::size_t>(Category)].load(std::memory_order_relaxed);
+        }
+
+        const std::size_t MemoryAccount::GetTotalBytes()
+        {
+            std::size_t total = 0;
+            for (auto& bytes : m_bytes)
+            {
+                total += bytes.load(std::memory_order_relaxed);
+            }
+            return total;
+        }
+
+        const DataSource* MemoryAccount::GetSource()
+        {
+            return m_source;
+        }
+
+        void MemoryAccount::Detach()
+        {
+            m_source = nullptr;
+        }
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "include/MemoryGovernor.hpp"
+
+#include <algorithm>
+
+namespace mt
+{
+    SourceMemory::SourceMemory() :
+        source(nullptr),
+        stagingbytes(0),
+        framebytes(0),
+        audiobytes(0),
+        totalbytes(0)
+    { }
+
+    MemoryGovernor::MemoryGovernor() :
+        m_limit(0),
+        m_used(0),
+        m_lock(),
+        m_accounts()
+    { }
+
+    MemoryGovernor& MemoryGovernor::GetInstance()
+    {
+        static MemoryGovernor instance;
+        return instance;
+    }
+
+    priv::MemoryAccountPtr MemoryGovernor::CreateAccount(const DataSource* Source)
+    {
+        priv::MemoryAccountPtr account(std::make_shared<priv::MemoryAccount>(Source));
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_accounts.erase(std::remove_if(m_accounts.begin(), m_accounts.end(), [](const std::weak_ptr<priv::MemoryAccount>& Account) { return Account.expired(); }), m_accounts.end());
+        m_accounts.push_back(account);
+        return account;
+    }
+
+    const std::size_t MemoryGovernor::GetLimit()
+    {
+        return m_limit;
+    }
+
+    void MemoryGovernor::SetLimit(std::size_t Bytes)
+    {
+        m_limit = Bytes;
+    }
+
+    const std::size_t MemoryGovernor::GetUsedBytes()
+    {
+        return m_used.load(std::memory_order_relaxed);
+    }
+
+    const bool MemoryGovernor::IsOverLimit()
+    {
+        std::size_t limit = m_limit;
+        return limit != 0 && m_used.load(std::memory_order_relaxed) > limit;
+    }
+
+    const std::vector<SourceMemory> MemoryGovernor::GetBreakdown()
+    {
+        std::vector<SourceMemory> breakdown;
+        std::lock_guard<std::mutex> lock(m_lock);
+        for (auto& weakaccount : m_accounts)
+        {
+            priv::MemoryAccountPtr account = weakaccount.lock();
+            if (!account) continue;
+            SourceMemory memory;
+            memory.source = account->GetSource();
+            memory.stagingbytes = account->GetBytes(MemoryCategory::Staging);
+            memory.framebytes = account->GetBytes(MemoryCategory::Frames);
+            memory.audiobytes = account->GetBytes(MemoryCategory::Audio);
+            memory.totalbytes = memory.stagingbytes + memory.framebytes + memory.audiobytes;
+            breakdown.push_back(memory);
+        }
+        return breakdown;
+    }
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+#include "include/PlaybackStats.hpp"
+#include "include/priv/StatsCollector.hpp"
+
+#include <algorithm>
+
+namespace mt
+{
+    TimeHistogram::TimeHistogram() :
+        buckets(),
+        count(0),
+        total(0),
+        max(0)
+    { }
+
+    const std::chrono::microseconds TimeHistogram::GetAverage() const
+    {
+        if (count == 0) return std::chrono::microseconds(0);
+        return total / static_cast<long long>(count);
+    }
+
+    const std::chrono::microseconds TimeHistogram::GetPercentile(double Percentile) const
+    {
+        // resolves to the upper edge of the bucket that holds the requested sample
+        if (count == 0) return std::chrono::microseconds(0);
+        uint64_t target = static_cast<uint64_t>(Percentile / 100.0 * (count - 1)) + 1;
+        uint64_t seen = 0;
+        for (std::size_t i = 0; i < BucketCount; i++)
+        {
+            seen += buckets[i];
+            if (seen >= target)
+            {
+                if (i == BucketCount - 1) return max;
+                return std::min(max, std::chrono::microseconds(1LL << i));
+            }
+        }
+        return max;
+    }
+
+    VideoPlaybackStats::VideoPlaybackStats() :
+        presentedframes(0),
+        droppedframes(0),
+        deadlinemisses(0),
+        queuedepth(0),
+        queuedepthhighwater(0)
+    { }
+
+    DataSourceStats::DataSourceStats() :
+        decodedvideoframes(0),
+        decodedaudioframes(0),
+        convertedframes(0),
+        presentedframes(0),
+        droppedframes(0),
+        deadlinemisses(0),
+        bytesread(0),
+        seekcount(0),
+        queuedepthhighwater(0),
+        audiodrift(0),
+        audiodriftcorrections(0),
+        audioresyncs(0),
+        framecachehits(0),
+        framecachemisses(0),
+        framecachebytes(0),
+        loopwraps(0),
+        videoqueuelimit(0),
+        audioqueuelimit(0),
+        queuetarget(0),
+        stagingbytes(0),
+        videoqueuebytes(0),
+        audioqueuebytes(0),
+        memorybytes(0),
+        parkedpackets(0),
+        parkedbytes(0),
+        readtime(),
+        decodetime(),
+        converttime(),
+        decodecopytime(),
+        seeklatency()
+    { }
+
+    namespace priv
+    {
+        AtomicHistogram::AtomicHistogram()
+        {
+            Reset();
+        }
+
+        void AtomicHistogram::Record(std::chrono::steady_clock::duration Duration)
+        {
+            long long microseconds = std::chrono::duration_cast<std::chrono::microseconds>(Duration).count();
+            if (microseconds < 0) microseconds = 0;
+            std::size_t bucket = 0;
+            while (bucket < TimeHistogram::BucketCount - 1 && (1LL << bucket) <= microseconds)
+            {
+                bucket++;
+            }
+            IncrementStat(m_buckets[bucket]);
+            IncrementStat(m_count);
+            IncrementStat(m_total, static_cast<uint64_t>(microseconds));
+            uint64_t current = m_max.load(std::memory_order_relaxed);
+            while (static_cast<uint64_t>(microseconds) > current && !m_max.compare_exchange_weak(current, microseconds, std::memory_order_relaxed));
+        }
+
+        const TimeHistogram AtomicHistogram::Snapshot() const
+        {
+            TimeHistogram snapshot;
+            for (std::size_t i = 0; i < TimeHistogram::BucketCount; i++)
+            {
+                snapshot.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+            }
+            snapshot.count = m_count.load(std::memory_order_relaxed);
+            snapshot.total = std::chrono::microseconds(m_total.load(std::memory_order_relaxed));
+            snapshot.max = std::chrono::microseconds(m_max.load(std::memory_order_relaxed));
+            return snapshot;
+        }
+
+        void AtomicHistogram::Reset()
+        {
+            for (auto& bucket : m_buckets)
+            {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+            m_count.store(0, std::memory_order_relaxed);
+            m_total.store(0, std::memory_order_relaxed);
+            m_max.store(0, std::memory_order_relaxed);
+        }
+
+        StatsCollector::StatsCollector()
+        {
+            Reset();
+        }
+
+        void StatsCollector::Fill(DataSourceStats& Stats) const
+        {
+            Stats.decodedvideoframes = decodedvideoframes.load(std::memory_order_relaxed);
+            Stats.decodedaudioframes = decodedaudioframes.load(std::memory_order_relaxed);
+            Stats.convertedframes = convertedframes.load(std::memory_order_relaxed);
+            Stats.presentedframes = presentedframes.load(std::memory_order_relaxed);
+            Stats.droppedframes = droppedframes.load(std::memory_order_relaxed);
+            Stats.bytesread = bytesread.load(std::memory_order_relaxed);
+            Stats.seekcount = seekcount.load(std::memory_order_relaxed);
+            Stats.queuedepthhighwater = queuedepthhighwater.load(std::memory_order_relaxed);
+            Stats.audiodrift = std::chrono::microseconds(audiodrift.load(std::memory_order_relaxed));
+            Stats.audiodriftcorrections = audiodriftcorrections.load(std::memory_order_relaxed);
+            Stats.audioresyncs = audioresyncs.load(std::memory_order_relaxed);
+            Stats.framecachehits = framecachehits.load(std::memory_order_relaxed);
+            Stats.framecachemisses = framecachemisses.load(std::memory_order_relaxed);
+            Stats.loopwraps = loopwraps.load(std::memory_order_relaxed);
+            Stats.readtime = readtime.Snapshot();
+            Stats.decodetime = decodetime.Snapshot();
+            Stats.converttime = converttime.Snapshot();
+            Stats.decodecopytime = decodecopytime.Snapshot();
+            Stats.seeklatency = seeklatency.Snapshot();
+        }
+
+        void StatsCollector::Reset()
+        {
+            decodedvideoframes.store(0, std::memory_order_relaxed);
+            decodedaudioframes.store(0, std::memory_order_relaxed);
+            convertedframes.store(0, std::memory_order_relaxed);
+            presentedframes.store(0, std::memory_order_relaxed);
+            droppedframes.store(0, std::memory_order_relaxed);
+            bytesread.store(0, std::memory_order_relaxed);
+            seekcount.store(0, std::memory_order_relaxed);
+            queuedepthhighwater.store(0, std::memory_order_relaxed);
+            audiodrift.store(0, std::memory_order_relaxed);
+            audiodriftcorrections.store(0, std::memory_order_relaxed);
+            audioresyncs.store(0, std::memory_order_relaxed);
+            framecachehits.store(0, std::memory_order_relaxed);
+            framecachemisses.store(0, std::memory_order_relaxed);
+            loopwraps.store(0, std::memory_order_relaxed);
+            readtime.Reset();
+            decodetime.Reset();
+            converttime.Reset();
+            decodecopytime.Reset();
+            seeklatency.Reset();
+        }
+    }
+}
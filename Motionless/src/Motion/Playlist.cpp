@@ -0,0 +1,385 @@
+#pragma once
+
+#include "include/Playlist.hpp"
+#include "include/priv/TraceScope.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#define PLAYLIST_PREROLL_TIMEOUT_MS 2000
+
+namespace mt
+{
+    Playlist::Playlist(bool EnableVideo, bool EnableAudio) :
+        m_enablevideo(EnableVideo),
+        m_enableaudio(EnableAudio),
+        m_itemlock(),
+        m_items(),
+        m_sourcecallback(),
+        m_looping(false),
+        m_playbackspeed(1.f),
+        m_state(State::Stopped),
+        m_endreached(false),
+        m_current(),
+        m_audiolock(),
+        m_currentaudio(nullptr),
+        m_preloadlock(),
+        m_preloadthread(),
+        m_next(),
+        m_retired(),
+        m_preloadready(false),
+        m_cancelpreload(false),
+        m_transitioncount(0),
+        m_latetransitioncount(0),
+        m_waitingfornext(false),
+        m_channelcount(0),
+        m_samplerate(0),
+        m_lastpacket()
+    { }
+
+    Playlist::~Playlist()
+    {
+        StopPreload();
+        {
+            std::lock_guard<std::mutex> lock(m_audiolock);
+            m_currentaudio = nullptr;
+        }
+        m_next.reset();
+        m_retired.reset();
+        m_current.reset();
+    }
+
+    void Playlist::Add(const std::string& Filename)
+    {
+        std::lock_guard<std::mutex> lock(m_itemlock);
+        m_items.push_back(Filename);
+    }
+
+    void Playlist::Clear()
+    {
+        Stop();
+        std::lock_guard<std::mutex> lock(m_itemlock);
+        m_items.clear();
+    }
+
+    const std::size_t Playlist::GetItemCount()
+    {
+        std::lock_guard<std::mutex> lock(m_itemlock);
+        return m_items.size();
+    }
+
+    const int Playlist::GetCurrentItem()
+    {
+        return m_current ? static_cast<int>(m_current->index) : -1;
+    }
+
+    bool Playlist::SetCurrentItem(std::size_t Index)
+    {
+        if (Index >= GetItemCount())
+        {
+            std::cout << "Motion: Invalid playlist item: " << Index << std::endl;
+            return false;
+        }
+        StopPreload();
+        m_next.reset();
+        std::unique_ptr<Entry> item = LoadEntry(Index, false);
+        if (!item) return false;
+        m_endreached = false;
+        m_waitingfornext = false;
+        MakeCurrent(std::move(item), std::chrono::microseconds(0));
+        std::size_t nextindex;
+        if (GetNextIndex(Index, nextindex)) StartPreload(nextindex);
+        return true;
+    }
+
+    const bool Playlist::IsLooping()
+    {
+        return m_looping;
+    }
+
+    void Playlist::SetLooping(bool Looping)
+    {
+        m_looping = Looping;
+    }
+
+    void Playlist::SetSourceCallback(SourceCallback Callback)
+    {
+        std::lock_guard<std::mutex> lock(m_itemlock);
+        m_sourcecallback = std::move(Callback);
+    }
+
+    void Playlist::Play()
+    {
+        if (m_state == State::Playing) return;
+        if ((!m_current || m_endreached) && (GetItemCount() == 0 || !SetCurrentItem(0))) return;
+        m_state = State::Playing;
+        m_current->source->Play();
+    }
+
+    void Playlist::Pause()
+    {
+        if (m_state != State::Playing) return;
+        m_state = State::Paused;
+        if (m_current) m_current->source->Pause();
+    }
+
+    void Playlist::Stop()
+    {
+        // back to the first item, which loads again with the next Play()
+        StopPreload();
+        m_next.reset();
+        m_state = State::Stopped;
+        m_endreached = false;
+        m_waitingfornext = false;
+        MakeCurrent(nullptr, std::chrono::microseconds(0));
+        m_retired.reset();
+    }
+
+    const State Playlist::GetState()
+    {
+        return m_state;
+    }
+
+    const float Playlist::GetPlaybackSpeed()
+    {
+        return m_playbackspeed;
+    }
+
+    void Playlist::SetPlaybackSpeed(float PlaybackSpeed)
+    {
+        if (m_current)
+        {
+            m_current->source->SetPlaybackSpeed(PlaybackSpeed);
+            m_playbackspeed = m_current->source->GetPlaybackSpeed();
+        }
+        else
+        {
+            m_playbackspeed = PlaybackSpeed;
+        }
+    }
+
+    void Playlist::Update()
+    {
+        MT_TRACE_SCOPE("Playlist::Update");
+        if (!m_current) return;
+        m_current->source->Update();
+        std::chrono::microseconds overrun(0);
+        if (m_state != State::Playing || !IsItemFinished(*m_current, overrun)) return;
+        std::size_t nextindex;
+        if (!GetNextIndex(m_current->index, nextindex))
+        {
+            // the last frame stays up, Play() starts over from the first item
+            m_current->source->Pause();
+            m_state = State::Stopped;
+            m_endreached = true;
+            return;
+        }
+        // an item appended while the last one played has not been preloaded yet
+        if (!m_preloadthread) StartPreload(nextindex);
+        if (!m_preloadready)
+        {
+            if (!m_waitingfornext) priv::IncrementStat(m_latetransitioncount);
+            m_waitingfornext = true;
+            return;
+        }
+        StopPreload();
+        std::unique_ptr<Entry> next;
+        {
+            std::lock_guard<std::mutex> lock(m_preloadlock);
+            next = std::move(m_next);
+        }
+        if (!next)
+        {
+            // none of the remaining items could be opened
+            m_current->source->Pause();
+            m_state = State::Stopped;
+            m_endreached = true;
+            return;
+        }
+        // time spent waiting for a late item is not carried over, it starts from its first frame
+        MakeCurrent(std::move(next), m_waitingfornext ? std::chrono::microseconds(0) : overrun);
+        m_waitingfornext = false;
+        priv::IncrementStat(m_transitioncount);
+        if (GetNextIndex(m_current->index, nextindex)) StartPreload(nextindex);
+    }
+
+    const bool Playlist::IsEndofPlaylistReached()
+    {
+        return m_endreached;
+    }
+
+    DataSource* Playlist::GetCurrentSource()
+    {
+        return m_current ? m_current->source.get() : nullptr;
+    }
+
+    priv::VideoPacket* Playlist::GetLastPacket() const
+    {
+        priv::VideoPacket* packet = m_current && m_current->video ? m_current->video->GetLastPacket() : nullptr;
+        return packet ? packet : m_lastpacket.get();
+    }
+
+    std::size_t Playlist::ReadSamples(int16_t* Destination, std::size_t FrameCount)
+    {
+        // the switch only holds the lock to exchange the pointer, never wait on it from the device
+        std::unique_lock<std::mutex> lock(m_audiolock, std::try_to_lock);
+        if (lock.owns_lock() && m_currentaudio) return m_currentaudio->ReadSamples(Destination, FrameCount);
+        std::fill(Destination, Destination + FrameCount * std::max(m_channelcount.load(), 1), static_cast<int16_t>(0));
+        return 0;
+    }
+
+    const int Playlist::GetChannelCount()
+    {
+        return m_channelcount;
+    }
+
+    const int Playlist::GetSampleRate()
+    {
+        return m_samplerate;
+    }
+
+    const uint64_t Playlist::GetTransitionCount()
+    {
+        return m_transitioncount.load(std::memory_order_relaxed);
+    }
+
+    const uint64_t Playlist::GetLateTransitionCount()
+    {
+        return m_latetransitioncount.load(std::memory_order_relaxed);
+    }
+
+    std::unique_ptr<Playlist::Entry> Playlist::LoadEntry(std::size_t Index, bool Preroll)
+    {
+        std::string filename;
+        SourceCallback callback;
+        {
+            std::lock_guard<std::mutex> lock(m_itemlock);
+            if (Index >= m_items.size()) return nullptr;
+            filename = m_items[Index];
+            callback = m_sourcecallback;
+        }
+        std::unique_ptr<Entry> item(new Entry());
+        item->index = Index;
+        item->source.reset(new DataSource());
+        DataSource& source = *item->source;
+        if (!source.LoadFromFile(filename, m_enablevideo, m_enableaudio)) return nullptr;
+        source.SetPlaybackSpeed(m_playbackspeed);
+        if (callback) callback(source);
+        // the decoder idles without consumers, attaching them starts the pre-roll
+        if (source.HasVideo()) item->video.reset(new VideoPlayback(source));
+        if (source.HasAudio()) item->audio.reset(new AudioPlayback(source));
+        source.RequestDecode();
+        if (!Preroll) return item;
+        MT_TRACE_SCOPE("playlist preroll");
+        // ready once the first frame and the first samples are decoded, or there is nothing more to wait for
+        auto timeout = std::chrono::steady_clock::now() + std::chrono::milliseconds(PLAYLIST_PREROLL_TIMEOUT_MS);
+        while (!m_cancelpreload && !source.m_playingtoeof && std::chrono::steady_clock::now() < timeout)
+        {
+            bool videoready = !item->video || item->video->GetStats().queuedepth > 0;
+            bool audioready = !item->audio || item->audio->GetBufferedFrameCount() > 0;
+            if (videoready && audioready) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return item;
+    }
+
+    bool Playlist::GetNextIndex(std::size_t Index, std::size_t& NextIndex)
+    {
+        std::lock_guard<std::mutex> lock(m_itemlock);
+        if (Index + 1 < m_items.size()) NextIndex = Index + 1;
+        else if (m_looping && !m_items.empty()) NextIndex = 0;
+        else return false;
+        return true;
+    }
+
+    void Playlist::StartPreload(std::size_t Index)
+    {
+        StopPreload();
+        m_cancelpreload = false;
+        m_preloadready = false;
+        m_preloadthread.reset(new std::thread(&Playlist::PreloadRun, this, Index));
+    }
+
+    void Playlist::StopPreload()
+    {
+        if (!m_preloadthread) return;
+        m_cancelpreload = true;
+        if (m_preloadthread->joinable()) m_preloadthread->join();
+        m_preloadthread.reset(nullptr);
+    }
+
+    void Playlist::PreloadRun(std::size_t Index)
+    {
+        MT_TRACE_THREAD_NAME("Motion playlist preload");
+        std::unique_ptr<Entry> retired;
+        {
+            std::lock_guard<std::mutex> lock(m_preloadlock);
+            retired = std::move(m_retired);
+        }
+        // closing the item that just ended takes as long as opening one, keep both off the caller's thread
+        retired.reset();
+        std::unique_ptr<Entry> item;
+        std::size_t index = Index;
+        for (std::size_t attempt = 0; attempt < GetItemCount() && !m_cancelpreload; attempt++)
+        {
+            // items that fail to open are skipped
+            item = LoadEntry(index, true);
+            if (item || !GetNextIndex(index, index)) break;
+        }
+        std::lock_guard<std::mutex> lock(m_preloadlock);
+        m_next = std::move(item);
+        m_preloadready = true;
+    }
+
+    bool Playlist::IsItemFinished(Entry& Item, std::chrono::microseconds& Overrun)
+    {
+        // the item ends once its last frame has been up for a frame time, Overrun is how far the clock went past that
+        DataSource& source = *Item.source;
+        Overrun = std::chrono::microseconds(0);
+        // a container that reports a shorter length than its frames stops the source first
+        if (source.IsEndofFileReached()) return true;
+        if (source.GetState() != State::Playing || !source.m_playingtoeof) return false;
+        if (Item.video)
+        {
+            priv::VideoConsumer& video = *Item.video->m_consumer;
+            std::lock_guard<std::mutex> lock(video.m_protectionlock);
+            if (!video.m_queuedvideopackets.empty()) return false;
+            if (video.m_lastpts == std::chrono::microseconds::min()) return true;
+            auto end = video.m_lastpts + video.m_frametime;
+            if (source.m_playingoffset < end) return false;
+            Overrun = source.m_playingoffset - end;
+            return true;
+        }
+        return !Item.audio || Item.audio->GetBufferedFrameCount() == 0;
+    }
+
+    void Playlist::MakeCurrent(std::unique_ptr<Entry> Item, std::chrono::microseconds Overrun)
+    {
+        std::unique_ptr<Entry> previous = std::move(m_current);
+        // keeps the previous item's last frame up in case the next one has nothing to show yet
+        if (previous && previous->video && previous->video->m_consumer->m_lastpacket) m_lastpacket = std::move(previous->video->m_consumer->m_lastpacket);
+        m_current = std::move(Item);
+        {
+            std::lock_guard<std::mutex> lock(m_audiolock);
+            m_currentaudio = m_current ? m_current->audio.get() : nullptr;
+        }
+        if (m_current && m_current->audio)
+        {
+            m_channelcount = m_current->audio->GetChannelCount();
+            m_samplerate = m_current->audio->GetSampleRate();
+        }
+        if (previous)
+        {
+            std::lock_guard<std::mutex> lock(m_preloadlock);
+            m_retired = std::move(previous);
+        }
+        if (!m_current || m_state != State::Playing) return;
+        DataSource& source = *m_current->source;
+        source.Play();
+        // the next item starts where the previous one ran over, then shows its first frame in this same update
+        float speed = source.GetPlaybackSpeed();
+        source.m_start -= std::chrono::microseconds(static_cast<long long>(Overrun.count() / speed));
+        source.Update();
+        if (m_current->video && m_current->video->GetLastPacket()) m_lastpacket.reset();
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "include/priv/ReadyNotifier.hpp"
+
+#include <cstdint>
+#include <iostream>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+namespace mt
+{
+    namespace priv
+    {
+        ReadyNotifier::ReadyNotifier() :
+            m_lock(),
+            m_fd(-1)
+        { }
+
+        ReadyNotifier::~ReadyNotifier()
+        {
+#ifdef __linux__
+            if (m_fd >= 0) close(m_fd);
+#endif
+        }
+
+        int ReadyNotifier::GetFd()
+        {
+#ifdef __linux__
+            std::lock_guard<std::mutex> lock(m_lock);
+            if (m_fd < 0)
+            {
+                int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+                if (fd < 0) std::cout << "Motion: Failed to create eventfd" << std::endl;
+                m_fd = fd;
+            }
+#endif
+            return m_fd;
+        }
+
+        void ReadyNotifier::Signal()
+        {
+#ifdef __linux__
+            // the counter only has to be non zero, a full one is still readable
+            int fd = m_fd.load(std::memory_order_acquire);
+            if (fd < 0) return;
+            uint64_t one = 1;
+            ssize_t written = write(fd, &one, sizeof(one));
+            (void)written;
+#endif
+        }
+
+        void ReadyNotifier::Clear()
+        {
+#ifdef __linux__
+            int fd = m_fd.load(std::memory_order_acquire);
+            if (fd < 0) return;
+            uint64_t count;
+            ssize_t readbytes = read(fd, &count, sizeof(count));
+            (void)readbytes;
+#endif
+        }
+    }
+}
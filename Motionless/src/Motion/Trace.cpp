@@ -0,0 +1,242 @@
+#pragma once
+
+#include "include/Trace.hpp"
+#include "include/priv/TraceScope.hpp"
+
+#ifdef MOTIONLESS_TRACING
+
+#include <climits>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#define TRACE_EVENTS_PER_THREAD 16384
+
+namespace mt
+{
+    namespace priv
+    {
+        std::atomic<bool> g_tracerecording(false);
+
+        namespace
+        {
+            struct TraceEvent
+            {
+                const char* name;
+                long long start;
+                long long duration;
+            };
+
+            /// Written by exactly one thread at a time, the dump only reads events published
+            /// through writecount so recording never takes a lock.  Only the owning thread resets
+            /// it, Clear() just moves the epoch on and the owner starts over with its next event.
+            struct TraceBuffer
+            {
+                std::unique_ptr<TraceEvent[]> events;
+                std::atomic<uint64_t> writecount;
+                std::atomic<uint64_t> epoch;
+                std::atomic<const char*> threadname;
+                std::atomic<bool> inuse;
+                std::size_t threadid;
+            };
+
+            std::mutex g_tracebufferlock;
+            std::vector<std::unique_ptr<TraceBuffer>> g_tracebuffers;
+            std::size_t g_tracethreadcount = 0;
+            std::atomic<uint64_t> g_traceepoch(0);
+
+            /// Hands the buffer back for reuse when its thread exits, decode threads are
+            /// respawned on every seek so buffers would otherwise pile up.
+            class TraceBufferLease
+            {
+            public:
+                TraceBuffer* buffer = nullptr;
+
+                ~TraceBufferLease()
+                {
+                    if (buffer) buffer->inuse = false;
+                }
+            };
+
+            thread_local TraceBufferLease t_tracebuffer;
+
+            TraceBuffer* AcquireTraceBuffer()
+            {
+                if (t_tracebuffer.buffer) return t_tracebuffer.buffer;
+                std::lock_guard<std::mutex> lock(g_tracebufferlock);
+                for (auto& buffer : g_tracebuffers)
+                {
+                    if (!buffer->inuse)
+                    {
+                        // the previous thread's events go with it, the new one gets its own tid
+                        buffer->inuse = true;
+                        buffer->threadname = nullptr;
+                        buffer->writecount = 0;
+                        buffer->epoch = g_traceepoch.load();
+                        buffer->threadid = ++g_tracethreadcount;
+                        t_tracebuffer.buffer = buffer.get();
+                        return buffer.get();
+                    }
+                }
+                std::unique_ptr<TraceBuffer> buffer(new TraceBuffer());
+                buffer->events.reset(new TraceEvent[TRACE_EVENTS_PER_THREAD]);
+                buffer->writecount = 0;
+                buffer->epoch = g_traceepoch.load();
+                buffer->threadname = nullptr;
+                buffer->inuse = true;
+                buffer->threadid = ++g_tracethreadcount;
+                t_tracebuffer.buffer = buffer.get();
+                g_tracebuffers.push_back(std::move(buffer));
+                return t_tracebuffer.buffer;
+            }
+
+            long long ToMicroseconds(std::chrono::steady_clock::time_point Time)
+            {
+                return std::chrono::duration_cast<std::chrono::microseconds>(Time.time_since_epoch()).count();
+            }
+
+            void WriteEscaped(std::ostream& Stream, const char* Text)
+            {
+                for (; *Text; Text++)
+                {
+                    if (*Text == '"' || *Text == '\\') Stream << '\\';
+                    Stream << *Text;
+                }
+            }
+        }
+
+        void TraceRecord(const char* Name, std::chrono::steady_clock::time_point Start, std::chrono::steady_clock::time_point End)
+        {
+            TraceBuffer* buffer = AcquireTraceBuffer();
+            uint64_t epoch = g_traceepoch.load(std::memory_order_acquire);
+            if (buffer->epoch.load(std::memory_order_relaxed) != epoch)
+            {
+                // cleared since this thread last recorded, the dump skips the buffer until it is reset
+                buffer->writecount.store(0, std::memory_order_relaxed);
+                buffer->epoch.store(epoch, std::memory_order_release);
+            }
+            uint64_t index = buffer->writecount.load(std::memory_order_relaxed);
+            TraceEvent& event = buffer->events[index % TRACE_EVENTS_PER_THREAD];
+            event.name = Name;
+            event.start = ToMicroseconds(Start);
+            event.duration = ToMicroseconds(End) - event.start;
+            buffer->writecount.store(index + 1, std::memory_order_release);
+        }
+
+        void TraceSetThreadName(const char* Name)
+        {
+            AcquireTraceBuffer()->threadname = Name;
+        }
+    }
+
+    const bool Trace::IsCompiledIn()
+    {
+        return true;
+    }
+
+    void Trace::Start()
+    {
+        priv::g_tracerecording = true;
+    }
+
+    void Trace::Stop()
+    {
+        priv::g_tracerecording = false;
+    }
+
+    void Trace::Clear()
+    {
+        // buffers belong to their threads, each one drops its events the next time it records
+        priv::g_traceepoch++;
+    }
+
+    const bool Trace::IsRecording()
+    {
+        return priv::g_tracerecording;
+    }
+
+    bool Trace::WriteChromeTrace(const std::string& Filename)
+    {
+        return WriteChromeTrace(Filename, std::chrono::steady_clock::time_point::min(), std::chrono::steady_clock::time_point::max());
+    }
+
+    bool Trace::WriteChromeTrace(const std::string& Filename, std::chrono::steady_clock::time_point From, std::chrono::steady_clock::time_point To)
+    {
+        std::ofstream file(Filename, std::ios::out | std::ios::trunc);
+        if (!file)
+        {
+            std::cout << "Motion: Failed to open trace file: '" << Filename << "'" << std::endl;
+            return false;
+        }
+        long long from = From == std::chrono::steady_clock::time_point::min() ? LLONG_MIN : priv::ToMicroseconds(From);
+        long long to = To == std::chrono::steady_clock::time_point::max() ? LLONG_MAX : priv::ToMicroseconds(To);
+        bool first = true;
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        std::lock_guard<std::mutex> lock(priv::g_tracebufferlock);
+        uint64_t epoch = priv::g_traceepoch.load();
+        for (auto& buffer : priv::g_tracebuffers)
+        {
+            const char* threadname = buffer->threadname;
+            if (threadname)
+            {
+                file << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadid << ",\"args\":{\"name\":\"";
+                priv::WriteEscaped(file, threadname);
+                file << "\"}}";
+                first = false;
+            }
+            if (buffer->epoch.load(std::memory_order_acquire) != epoch) continue;
+            uint64_t writecount = buffer->writecount.load(std::memory_order_acquire);
+            uint64_t begin = writecount > TRACE_EVENTS_PER_THREAD ? writecount - TRACE_EVENTS_PER_THREAD : 0;
+            for (uint64_t i = begin; i < writecount; i++)
+            {
+                const priv::TraceEvent& event = buffer->events[i % TRACE_EVENTS_PER_THREAD];
+                if (event.start + event.duration < from || event.start > to) continue;
+                file << (first ? "" : ",") << "\n{\"name\":\"";
+                priv::WriteEscaped(file, event.name);
+                file << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadid << ",\"ts\":" << event.start << ",\"dur\":" << event.duration << "}";
+                first = false;
+            }
+        }
+        file << "\n]}\n";
+        return static_cast<bool>(file);
+    }
+}
+
+#else
+
+namespace mt
+{
+    const bool Trace::IsCompiledIn()
+    {
+        return false;
+    }
+
+    void Trace::Start()
+    { }
+
+    void Trace::Stop()
+    { }
+
+    void Trace::Clear()
+    { }
+
+    const bool Trace::IsRecording()
+    {
+        return false;
+    }
+
+    bool Trace::WriteChromeTrace(const std::string&)
+    {
+        return false;
+    }
+
+    bool Trace::WriteChromeTrace(const std::string&, std::chrono::steady_clock::time_point, std::chrono::steady_clock::time_point)
+    {
+        return false;
+    }
+}
+
+#endif
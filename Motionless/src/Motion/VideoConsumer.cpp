@@ -0,0 +1,236 @@
+#pragma once
+
+#include "include/DataSource.hpp"
+#include "include/priv/VideoConsumer.hpp"
+#include "include/priv/TraceScope.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace mt
+{
+    namespace priv
+    {
+        VideoConsumer::VideoConsumer(DataSource& DataSource) :
+            m_datasource(&DataSource),
+            m_protectionlock(),
+            m_queuedvideopackets(),
+            m_framequeued(),
+            m_offline(false),
+            m_asynclock(),
+            m_pendingcallback(),
+            m_pendingexecutor(),
+            m_elapsed(),
+            m_frametime(0),
+            m_framejump(0),
+            m_nextdue(std::chrono::microseconds::max()),
+            m_lastpts(std::chrono::microseconds::min()),
+            m_playedframecount(0),
+            m_deadlinemisscount(0),
+            m_presentedframecount(0),
+            m_droppedframecount(0),
+            m_queuehighwater(0),
+            m_ready(),
+            m_lastpacket()
+        {
+            SourceReloaded();
+        }
+
+        void VideoConsumer::Update(std::chrono::microseconds DeltaTime)
+        {
+            MT_TRACE_SCOPE("VideoPlayback::Update");
+            if (m_datasource && m_datasource->HasVideo())
+            {
+                int jumpcount = 0;
+                if (m_datasource->GetState() == State::Playing)
+                {
+                    m_elapsed += DeltaTime;
+                    jumpcount = static_cast<int>(std::floor(m_elapsed / m_frametime));
+
+                    m_elapsed -= m_frametime * jumpcount;
+                    m_framejump += jumpcount;
+                }
+                std::lock_guard<std::mutex> lock(m_protectionlock);
+                while (m_queuedvideopackets.size() > 0)
+                {
+                    if (m_framejump > 1)
+                    {
+                        m_framejump -= 1;
+                        m_playedframecount++;
+                        IncrementStat(m_droppedframecount);
+                        IncrementStat(m_datasource->m_stats.droppedframes);
+                        MT_TRACE_SCOPE("queue pop dropped");
+                        m_queuedvideopackets.pop();
+                    }
+                    else if (m_framejump == 1)
+                    {
+                        m_framejump -= 1;
+                        Present(m_queuedvideopackets.front());
+                        m_queuedvideopackets.pop();
+                        break;
+                    }
+                    else
+                    {
+                        break;
+                    }
+                }
+                if (jumpcount > 0 && m_framejump > 0 && !m_datasource->m_playingtoeof)
+                {
+                    // frames came due this update but the decoder had nothing ready for us
+                    unsigned int misses = static_cast<unsigned int>(std::min(jumpcount, m_framejump));
+                    m_deadlinemisscount += misses;
+                    m_datasource->m_deadlinemisscount += misses;
+                }
+            }
+        }
+
+        void VideoConsumer::UpdateToClock(std::chrono::microseconds Clock, bool Reverse)
+        {
+            // timestamp mode: present the newest queued frame that is due, anything older is late.
+            // Reverse playback queues frames in descending order and runs the clock backwards.
+            MT_TRACE_SCOPE("VideoPlayback::UpdateToClock");
+            if (m_datasource && m_datasource->HasVideo())
+            {
+                std::lock_guard<std::mutex> lock(m_protectionlock);
+                VideoPacketPtr due;
+                while (m_queuedvideopackets.size() > 0 && (Reverse ? m_queuedvideopackets.front()->pts >= Clock : m_queuedvideopackets.front()->pts <= Clock))
+                {
+                    if (due)
+                    {
+                        m_playedframecount++;
+                        IncrementStat(m_droppedframecount);
+                        IncrementStat(m_datasource->m_stats.droppedframes);
+                    }
+                    due = m_queuedvideopackets.front();
+                    m_queuedvideopackets.pop();
+                }
+                if (due)
+                {
+                    Present(due);
+                    m_nextdue = Reverse ? due->pts - m_frametime : due->pts + m_frametime;
+                }
+                else if (m_queuedvideopackets.size() == 0 && !m_datasource->m_playingtoeof && m_frametime.count() > 0 && m_nextdue != std::chrono::microseconds::max())
+                {
+                    while (Reverse ? m_nextdue >= Clock : m_nextdue <= Clock)
+                    {
+                        // the clock passed a frame slot and the decoder had nothing ready for it
+                        m_nextdue += Reverse ? -m_frametime : m_frametime;
+                        m_deadlinemisscount++;
+                        m_datasource->m_deadlinemisscount++;
+                    }
+                }
+            }
+        }
+
+        bool VideoConsumer::StepPast(std::chrono::microseconds Clock, bool Reverse)
+        {
+            // drops whatever is queued on the wrong side of the last shown frame and presents the next one
+            std::lock_guard<std::mutex> lock(m_protectionlock);
+            bool presented = m_lastpts != std::chrono::microseconds::min();
+            auto reference = presented ? m_lastpts : Clock;
+            while (m_queuedvideopackets.size() > 0)
+            {
+                auto pts = m_queuedvideopackets.front()->pts;
+                bool past = Reverse ? pts < reference : (presented ? pts > reference : pts >= reference);
+                if (past)
+                {
+                    Present(m_queuedvideopackets.front());
+                    m_queuedvideopackets.pop();
+                    m_nextdue = std::chrono::microseconds::max();
+                    return true;
+                }
+                m_queuedvideopackets.pop();
+            }
+            return false;
+        }
+
+        void VideoConsumer::Present(const VideoPacketPtr& Packet)
+        {
+            // expects m_protectionlock to be held
+            m_playedframecount++;
+            IncrementStat(m_presentedframecount);
+            IncrementStat(m_datasource->m_stats.presentedframes);
+            // packets are never written after they are queued, the shown one is shared rather than copied
+            m_lastpacket = Packet;
+            m_lastpts = Packet->pts;
+        }
+
+        void VideoConsumer::SourceReloaded()
+        {
+            if (m_datasource->HasVideo())
+            {
+                m_frametime = m_datasource->GetVideoFrameTime();
+            }
+        }
+
+        void VideoConsumer::StateChanged(State PreviousState, State NewState)
+        {
+            if (NewState == State::Playing && PreviousState == State::Stopped)
+            {
+                m_framejump = 1;
+                m_playedframecount = 0;
+            }
+            else if (NewState == State::Stopped)
+            {
+                m_framejump = 0;
+                m_nextdue = std::chrono::microseconds::max();
+                m_lastpts = std::chrono::microseconds::min();
+                m_playedframecount = 0;
+                std::lock_guard<std::mutex> lock(m_protectionlock);
+                while (m_queuedvideopackets.size() > 0)
+                {
+                    m_queuedvideopackets.pop();
+                }
+            }
+        }
+
+        void VideoConsumer::ResetStats()
+        {
+            m_presentedframecount.store(0, std::memory_order_relaxed);
+            m_droppedframecount.store(0, std::memory_order_relaxed);
+            m_queuehighwater.store(0, std::memory_order_relaxed);
+            m_deadlinemisscount = 0;
+        }
+
+        bool VideoConsumer::TakeFrame(VideoPacketPtr& Frame)
+        {
+            // expects m_protectionlock to be held
+            DataSource* datasource = m_datasource;
+            if (m_queuedvideopackets.empty())
+            {
+                Frame = nullptr;
+                return !datasource || !datasource->HasVideo() || datasource->m_playingtoeof;
+            }
+            Frame = m_queuedvideopackets.front();
+            m_queuedvideopackets.pop();
+            m_playedframecount++;
+            m_lastpts = Frame->pts;
+            IncrementStat(m_presentedframecount);
+            IncrementStat(datasource->m_stats.presentedframes);
+            return true;
+        }
+
+        std::function<void()> VideoConsumer::TakePending()
+        {
+            // called while the source walks its playbacks, the task has to run after it is done
+            std::lock_guard<std::mutex> asynclock(m_asynclock);
+            if (!m_pendingcallback) return nullptr;
+            VideoPacketPtr frame;
+            {
+                std::lock_guard<std::mutex> lock(m_protectionlock);
+                if (!TakeFrame(frame)) return nullptr;
+            }
+            std::function<void()> task = MakeTask(std::move(m_pendingcallback), std::move(m_pendingexecutor), std::move(frame));
+            m_pendingcallback = nullptr;
+            m_pendingexecutor = nullptr;
+            return task;
+        }
+
+        std::function<void()> VideoConsumer::MakeTask(FrameCallback Callback, Executor Executor, VideoPacketPtr Frame)
+        {
+            std::function<void()> task = [Callback, Frame]() { Callback(Frame); };
+            if (!Executor) return task;
+            return [Executor, task]() { Executor(task); };
+        }
+    }
+}
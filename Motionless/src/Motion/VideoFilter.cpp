@@ -0,0 +1,148 @@
+#pragma once
+
+#include "include/priv/VideoFilter.hpp"
+
+#include <string>
+
+extern "C"
+{
+#include <libavutil/mem.h>
+#include <libavutil/opt.h>
+}
+
+namespace mt
+{
+    namespace priv
+    {
+        VideoFilter::VideoFilter() :
+            m_graph(nullptr),
+            m_source(nullptr),
+            m_sink(nullptr),
+            m_output(av_frame_alloc()),
+            m_description(),
+            m_width(0),
+            m_height(0),
+            m_format(AV_PIX_FMT_NONE),
+            m_timebase(AVRational{ 1, 1 }),
+            m_aspectratio(AVRational{ 0, 1 })
+        { }
+
+        VideoFilter::~VideoFilter()
+        {
+            Destroy();
+            av_frame_free(&m_output);
+        }
+
+        bool VideoFilter::Create(const std::string& Description, int Width, int Height, AVPixelFormat Format, AVRational TimeBase, AVRational AspectRatio)
+        {
+            Destroy();
+            m_description = Description;
+            m_width = Width;
+            m_height = Height;
+            m_format = Format;
+            m_timebase = TimeBase;
+            m_aspectratio = AspectRatio;
+            if (Description.empty()) return true;
+            if (!CreateGraph())
+            {
+                if (m_graph) avfilter_graph_free(&m_graph);
+                m_graph = nullptr;
+                return false;
+            }
+            return true;
+        }
+
+        bool VideoFilter::CreateGraph()
+        {
+            avfilter_register_all();
+            m_graph = avfilter_graph_alloc();
+            if (!m_graph) return false;
+            // threads have to be set before the first filter is added, 0 lets libavfilter pick per core
+            m_graph->nb_threads = 0;
+            m_graph->thread_type = AVFILTER_THREAD_SLICE;
+            m_graph->scale_sws_opts = av_strdup("flags=fast_bilinear");
+            std::string sourceargs = "video_size=" + std::to_string(m_width) + "x" + std::to_string(m_height) +
+                ":pix_fmt=" + std::to_string(static_cast<int>(m_format)) +
+                ":time_base=" + std::to_string(m_timebase.num) + "/" + std::to_string(m_timebase.den) +
+                ":pixel_aspect=" + std::to_string(m_aspectratio.num) + "/" + std::to_string(m_aspectratio.den > 0 ? m_aspectratio.den : 1);
+            if (avfilter_graph_create_filter(&m_source, avfilter_get_by_name("buffer"), "in", sourceargs.c_str(), nullptr, m_graph) < 0) return false;
+            if (avfilter_graph_create_filter(&m_sink, avfilter_get_by_name("buffersink"), "out", nullptr, nullptr, m_graph) < 0) return false;
+            const AVPixelFormat pixelformats[] = { AV_PIX_FMT_RGBA, AV_PIX_FMT_NONE };
+            if (av_opt_set_int_list(m_sink, "pix_fmts", pixelformats, AV_PIX_FMT_NONE, AV_OPT_SEARCH_CHILDREN) < 0) return false;
+            // the parser sees the chain with its loose ends named after the source and sink
+            AVFilterInOut* outputs = avfilter_inout_alloc();
+            AVFilterInOut* inputs = avfilter_inout_alloc();
+            if (!outputs || !inputs)
+            {
+                avfilter_inout_free(&outputs);
+                avfilter_inout_free(&inputs);
+                return false;
+            }
+            outputs->name = av_strdup("in");
+            outputs->filter_ctx = m_source;
+            outputs->pad_idx = 0;
+            outputs->next = nullptr;
+            inputs->name = av_strdup("out");
+            inputs->filter_ctx = m_sink;
+            inputs->pad_idx = 0;
+            inputs->next = nullptr;
+            int result = avfilter_graph_parse_ptr(m_graph, m_description.c_str(), &inputs, &outputs, nullptr);
+            avfilter_inout_free(&outputs);
+            avfilter_inout_free(&inputs);
+            if (result < 0) return false;
+            return avfilter_graph_config(m_graph, nullptr) >= 0;
+        }
+
+        void VideoFilter::Destroy()
+        {
+            if (m_graph) avfilter_graph_free(&m_graph);
+            m_graph = nullptr;
+            m_source = nullptr;
+            m_sink = nullptr;
+        }
+
+        bool VideoFilter::Flush()
+        {
+            if (!m_graph) return true;
+            return Create(std::string(m_description), m_width, m_height, m_format, m_timebase, m_aspectratio);
+        }
+
+        const std::string& VideoFilter::GetDescription() const
+        {
+            return m_description;
+        }
+
+        bool VideoFilter::IsActive() const
+        {
+            return m_graph != nullptr;
+        }
+
+        int VideoFilter::GetOutputWidth() const
+        {
+            return m_sink ? m_sink->inputs[0]->w : m_width;
+        }
+
+        int VideoFilter::GetOutputHeight() const
+        {
+            return m_sink ? m_sink->inputs[0]->h : m_height;
+        }
+
+        AVRational VideoFilter::GetOutputTimeBase() const
+        {
+            return m_sink ? m_sink->inputs[0]->time_base : m_timebase;
+        }
+
+        bool VideoFilter::Process(AVFrame* Frame, const OutputCallback& Output)
+        {
+            if (!m_graph) return false;
+            // the source takes its own reference, the decoder keeps the frame
+            if (av_buffersrc_write_frame(m_source, Frame) < 0) return false;
+            while (av_buffersink_get_frame(m_sink, m_output) >= 0)
+            {
+                Output(m_output);
+                av_frame_unref(m_output);
+            }
+            return true;
+        }
+    }
+}
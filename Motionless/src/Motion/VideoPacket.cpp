@@ -4,28 +4,95 @@
 
 #include "include/priv/VideoPacket.hpp"
 
+#include <algorithm>
+
 
 namespace mt
 {
     namespace priv
     {
-        VideoPacket::VideoPacket(uint8_t* RGBABufferSource, int Width, int Height) :
-            m_rgbabuffer(new uint8_t[Width * Height * 4]), width(Width), height(Height)
+        VideoPacket::VideoPacket(uint8_t* RGBABufferSource, int Width, int Height, std::chrono::microseconds Pts, MemoryAccountPtr Account, int SourceStride) :
+            m_allocation(nullptr), m_rgbabuffer(nullptr), m_alignment(1), m_account(Account), m_sink(), m_shared(), width(Width), height(Height), stride(Width * 4), pts(Pts)
+        {
+            Allocate();
+            if (SourceStride == 0 || SourceStride == Width * 4)
+            {
+                std::memcpy(m_rgbabuffer, RGBABufferSource, Width * Height * 4);
+            }
+            else
+            {
+                // filter output rows are padded for alignment, the packet keeps them packed
+                for (int y = 0; y < Height; y++)
+                {
+                    std::memcpy(m_rgbabuffer + y * Width * 4, RGBABufferSource + y * SourceStride, Width * 4);
+                }
+            }
+        }
+
+        VideoPacket::VideoPacket(int Width, int Height, std::chrono::microseconds Pts, MemoryAccountPtr Account, FrameSinkPtr Sink, int Alignment) :
+            m_allocation(nullptr), m_rgbabuffer(nullptr), m_alignment(std::max(Alignment, 1)), m_account(Account), m_sink(Sink), m_shared(), width(Width), height(Height), stride(Width * 4), pts(Pts)
+        {
+            Allocate();
+        }
+
+        VideoPacket::VideoPacket(const std::shared_ptr<VideoPacket>& Source, std::chrono::microseconds Pts) :
+            m_allocation(nullptr), m_rgbabuffer(Source->m_rgbabuffer), m_alignment(Source->m_alignment), m_account(), m_sink(), m_shared(Source->m_shared ? Source->m_shared : Source), width(Source->width), height(Source->height), stride(Source->stride), pts(Pts)
         {
-            std::memcpy(m_rgbabuffer, RGBABufferSource, Width * Height * 4);
+            // the memory stays charged to and released by the packet that owns it
         }
 
-		VideoPacket::VideoPacket(const VideoPacket& other)
+		VideoPacket::VideoPacket(const VideoPacket& other) :
+            m_allocation(nullptr), m_rgbabuffer(nullptr), m_alignment(other.m_alignment), m_account(other.m_account), m_sink(), m_shared(), width(other.width), height(other.height), stride(other.width * 4), pts(other.pts)
         {
-			m_rgbabuffer = new uint8_t[other.width * other.height * 4];
-			width = other.width;
-			height = other.height;
-			std::memcpy(this->m_rgbabuffer ,other.m_rgbabuffer, other.width * other.height * 4);
+            // copies always live in our own memory, laid out the way the source asked for
+            Allocate();
+			for (int y = 0; y < height; y++)
+			{
+				std::memcpy(m_rgbabuffer + y * stride, other.m_rgbabuffer + y * other.stride, width * 4);
+			}
         }
 
         VideoPacket::~VideoPacket()
         {
-            delete[] m_rgbabuffer;
+            if (m_sink)
+            {
+                m_sink->ReleaseBuffer(m_rgbabuffer);
+                return;
+            }
+            delete[] m_allocation;
+            if (m_account) m_account->Release(MemoryCategory::Frames, static_cast<std::size_t>(stride) * height);
+        }
+
+        int VideoPacket::GetAlignedStride(int Width, int Alignment)
+        {
+            Alignment = std::max(Alignment, 1);
+            return (Width * 4 + Alignment - 1) / Alignment * Alignment;
+        }
+
+        void VideoPacket::Allocate()
+        {
+            int alignedstride = GetAlignedStride(width, m_alignment);
+            if (m_sink)
+            {
+                int sinkstride = alignedstride;
+                uint8_t* buffer = m_sink->AcquireBuffer(width, height, sinkstride);
+                if (buffer && sinkstride >= width * 4)
+                {
+                    m_rgbabuffer = buffer;
+                    stride = sinkstride;
+                    return;
+                }
+                // an exhausted sink or one that asks for rows narrower than a frame falls back to our memory
+                if (buffer) m_sink->ReleaseBuffer(buffer);
+                m_sink.reset();
+            }
+            // over allocated by the alignment so the first row can be moved up to a multiple of it,
+            // the stride keeps every row after it there too
+            stride = alignedstride;
+            m_allocation = new uint8_t[static_cast<std::size_t>(stride) * height + m_alignment - 1];
+            std::size_t misalignment = reinterpret_cast<std::uintptr_t>(m_allocation) % m_alignment;
+            m_rgbabuffer = m_allocation + (misalignment ? m_alignment - misalignment : 0);
+            if (m_account) m_account->Charge(MemoryCategory::Frames, static_cast<std::size_t>(stride) * height);
         }
 
         const uint8_t* VideoPacket::GetRGBABuffer()
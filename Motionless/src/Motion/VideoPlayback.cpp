@@ -6,108 +6,52 @@
 namespace mt
 {
     VideoPlayback::VideoPlayback(DataSource& DataSource) :
-        m_datasource(&DataSource),
-        m_protectionlock(),
-        m_queuedvideopackets(),
-		m_elapsed(),
-		m_frametime(0),
-        m_framejump(0),
-        m_playedframecount(0)
+        m_consumer(std::make_shared<priv::VideoConsumer>(DataSource))
     {
-        SourceReloaded();
-		std::lock_guard<std::mutex> lock(m_datasource->m_playbacklock);
-        m_datasource->m_videoplaybacks.push_back(this);
+        DataSource.AttachPlayback(m_consumer);
     }
 
     VideoPlayback::~VideoPlayback()
     {
-        if (m_datasource)
-        {
-			std::lock_guard<std::mutex> lock(m_datasource->m_playbacklock);
-            for (auto& videoplayback : m_datasource->m_videoplaybacks)
-            {
-                if (videoplayback == this)
-                {
-                    std::swap(videoplayback, m_datasource->m_videoplaybacks.back());
-                    m_datasource->m_videoplaybacks.pop_back();
-                    break;
-                }
-            }
-            m_datasource = nullptr;
-        }
+        // the source clears m_datasource when it goes away first.  Lists the render or decode thread
+        // are still walking keep the consumer alive, so nothing waits for them here.
+        if (m_consumer->m_datasource) m_consumer->m_datasource->DetachPlayback(m_consumer);
     }
 
-    void VideoPlayback::Update(std::chrono::microseconds DeltaTime)
-    {
-        if (m_datasource && m_datasource->HasVideo())
-        {
-            if (m_datasource->GetState() == State::Playing)
-            {
-				m_elapsed += DeltaTime;
-                int jumpcount = static_cast<int>(std::floor(m_elapsed / m_frametime));
-				
-				m_elapsed -= m_frametime * jumpcount;
-                m_framejump += jumpcount;
-            }
-			std::lock_guard<std::mutex> lock(m_protectionlock);
-            while (m_queuedvideopackets.size() > 0)
-            {
-                if (m_framejump > 1)
-                {
-                    m_framejump -= 1;
-                    m_playedframecount++;
-                    m_queuedvideopackets.pop();
-                }
-                else if (m_framejump == 1)
-                {
-                    m_framejump -= 1;
-                    m_playedframecount++;
-					m_lastpacket = std::make_unique<mt::priv::VideoPacket>(*m_queuedvideopackets.front().get());
-                    m_queuedvideopackets.pop();
-                    break;
-                }
-                else
-                {
-                    break;
-                }
-            }
-        }
-    }
-
-    void VideoPlayback::SourceReloaded()
+    unsigned int VideoPlayback::GetPlayedFrameCount() const
     {
-        if (m_datasource->HasVideo())
-        {
-			m_frametime = m_datasource->GetVideoFrameTime();
-        }
+        return m_consumer->m_playedframecount;
     }
 
-    void VideoPlayback::StateChanged(State PreviousState, State NewState)
+    unsigned int VideoPlayback::GetDeadlineMissCount() const
     {
-        if (NewState == State::Playing && PreviousState == State::Stopped)
-        {
-            m_framejump = 1;
-            m_playedframecount = 0;
-        }
-        else if (NewState == State::Stopped)
-        {
-            m_framejump = 0;
-            m_playedframecount = 0;
-			std::lock_guard<std::mutex> lock(m_protectionlock);
-            while (m_queuedvideopackets.size() > 0)
-            {
-                m_queuedvideopackets.pop();
-            }
-        }
+        return m_consumer->m_deadlinemisscount;
     }
 
-    unsigned int VideoPlayback::GetPlayedFrameCount() const
+    const VideoPlaybackStats VideoPlayback::GetStats()
     {
-        return m_playedframecount;
+        VideoPlaybackStats stats;
+        stats.presentedframes = m_consumer->m_presentedframecount.load(std::memory_order_relaxed);
+        stats.droppedframes = m_consumer->m_droppedframecount.load(std::memory_order_relaxed);
+        stats.deadlinemisses = m_consumer->m_deadlinemisscount;
+        stats.queuedepthhighwater = m_consumer->m_queuehighwater.load(std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(m_consumer->m_protectionlock);
+        stats.queuedepth = m_consumer->m_queuedvideopackets.size();
+        return stats;
     }
 
 	priv::VideoPacket* VideoPlayback::GetLastPacket() const
 	{
-		return m_lastpacket.get();
+		return m_consumer->m_lastpacket.get();
 	}
-}
\ No newline at end of file
+
+    const int VideoPlayback::GetReadyFd()
+    {
+        return m_consumer->m_ready.GetFd();
+    }
+
+    void VideoPlayback::ClearReady()
+    {
+        m_consumer->m_ready.Clear();
+    }
+}